@@ -22,14 +22,23 @@ DEFINES += QT_DEPRECATED_WARNINGS
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 
+# Трассировка по зонам (../trace.h): mapcreator_trace.json при выходе
+#DEFINES += ENABLE_TRACE
+
+INCLUDEPATH += ..
+
 SOURCES += \
         main.cpp \
         mainwindow.cpp \
-    cube.cpp
+    cube.cpp \
+    frametimer.cpp \
+    ../trace.cc
 
 HEADERS += \
         mainwindow.h \
-    cube.h
+    cube.h \
+    frametimer.h \
+    ../trace.h
 
 LIBS += -lopengl32
 
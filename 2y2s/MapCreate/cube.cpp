@@ -5,14 +5,16 @@
 
 Cube::Cube() :
         m_indexBuffer(QOpenGLBuffer::IndexBuffer),
-        m_texture(0)
+        m_texture(0),
+        m_flexible(false)
 {
 
 }
 
 Cube::Cube(const QVector <VertexData> &vetData, const QVector <GLuint> &indexes, const QImage &texture) :
         m_indexBuffer(QOpenGLBuffer::IndexBuffer),
-        m_texture(0)
+        m_texture(0),
+        m_flexible(false)
 {
     init (vetData, indexes, texture);
 }
@@ -77,6 +79,8 @@ void Cube::draw(QOpenGLShaderProgram *program, QOpenGLFunctions *functions)
     m_texture->bind(0);
     program->setUniformValue("u_texture", 0);
     program->setUniformValue("u_modelMatrix", m_modelMatrix);
+    // Прогиб по упругим формам - только для панели
+    program->setUniformValue("u_flexible", m_flexible ? 1.0f : 0.0f);
 
     m_vertexBuffer.bind();
     m_indexBuffer.bind();
@@ -99,7 +103,7 @@ void Cube::draw(QOpenGLShaderProgram *program, QOpenGLFunctions *functions)
     program->enableAttributeArray(location);
     program->setAttributeBuffer(location, GL_FLOAT, offset, 3, sizeof(VertexData));
 
-    functions->glDrawElements(GL_TRIANGLES, m_indexBuffer.size(), GL_UNSIGNED_INT, 0);
+    functions->glDrawElements(GL_TRIANGLES, m_indexBuffer.size() / sizeof(GLuint), GL_UNSIGNED_INT, 0);
 
     m_vertexBuffer.release();
     m_indexBuffer.release();
@@ -112,3 +116,8 @@ void Cube::translate(const QVector3D &trvec)
     m_modelMatrix.translate(trvec);
 }
 
+void Cube::setFlexible(bool flexible)
+{
+    m_flexible = flexible;
+}
+
@@ -34,11 +34,13 @@ public:
     void init (const QVector <VertexData> &vetData, const QVector <GLuint> &indexes, const QImage &texture);
     void draw (QOpenGLShaderProgram * program, QOpenGLFunctions * functions);
     void translate (const QVector3D &trvec);
+    void setFlexible (bool flexible);
 private:
     QOpenGLBuffer m_vertexBuffer;
     QOpenGLBuffer m_indexBuffer;
     QMatrix4x4 m_modelMatrix;
     QOpenGLTexture *m_texture;
+    bool m_flexible;
 };
 
 #endif // CUBE_H
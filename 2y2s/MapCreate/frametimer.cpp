@@ -0,0 +1,285 @@
+#include "frametimer.h"
+#include <QPainter>
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <cmath>
+
+static const char *stageNames[FRAME_STAGES] = { "read", "depth", "main" };
+
+FrameTimer::FrameTimer() :
+        m_gpu(false),
+        m_dropped(0),
+        m_frameStart(0),
+        m_stageStart(0),
+        m_timings(FRAME_HISTORY),
+        m_frames(0),
+        m_csvFirst(-1)
+{
+    for (int b = 0; b < FRAME_BUFFERS; b++)
+    {
+        m_pending[b] = -1;
+        for (int s = 0; s < FRAME_STAGES; s++)
+            m_issued[b][s] = false;
+    }
+    m_clock.start();
+}
+
+/*************************************************************************
+  Запросы создаются в initializeGL, когда контекст текущий. Без
+  GL_ARB_timer_query (GL < 3.3, часть ES) create() не проходит, и тогда
+  меряется только процессорное время.
+ *************************************************************************/
+void FrameTimer::init()
+{
+    m_gpu = true;
+    for (int b = 0; b < FRAME_BUFFERS; b++)
+        for (int s = FRAME_DEPTH; s < FRAME_STAGES; s++)
+            if (!m_queries[b][s].create())
+                m_gpu = false;
+
+    if (!m_gpu)
+        destroy();
+}
+
+void FrameTimer::destroy()
+{
+    for (int b = 0; b < FRAME_BUFFERS; b++)
+        for (int s = 0; s < FRAME_STAGES; s++)
+            if (m_queries[b][s].isCreated())
+                m_queries[b][s].destroy();
+    m_gpu = false;
+}
+
+bool FrameTimer::gpuAvailable() const
+{
+    return m_gpu;
+}
+
+FrameTiming &FrameTimer::timing(qint64 frame)
+{
+    return m_timings[int(frame % FRAME_HISTORY)];
+}
+
+/*************************************************************************
+  Результаты набора buffer (кадр FRAME_BUFFERS назад). Ждать результат
+  нельзя - это остановит конвейер, поэтому ещё не готовые запросы
+  пропускаются и считаются в m_dropped. Кадр после этого окончателен и
+  при записи идёт в CSV.
+ *************************************************************************/
+void FrameTimer::collect(int buffer)
+{
+    if (m_pending[buffer] < 0)
+        return;
+
+    FrameTiming &t = timing(m_pending[buffer]);
+    for (int s = 0; s < FRAME_STAGES; s++)
+    {
+        if (!m_issued[buffer][s])
+            continue;
+        if (m_queries[buffer][s].isResultAvailable())
+            t.gpu[s] = m_queries[buffer][s].waitForResult() / 1.0e6f;
+        else
+            m_dropped++;
+        m_issued[buffer][s] = false;
+    }
+    if (csvActive() && t.frame >= m_csvFirst)
+        writeCsv(t);
+    m_pending[buffer] = -1;
+}
+
+void FrameTimer::beginFrame()
+{
+    int buffer = int(m_frames % FRAME_BUFFERS);
+    collect(buffer);
+
+    FrameTiming &t = timing(m_frames);
+    t.frame = m_frames;
+    t.cpuFrame = 0.0f;
+    for (int s = 0; s < FRAME_STAGES; s++)
+    {
+        t.cpu[s] = 0.0f;
+        t.gpu[s] = -1.0f;
+    }
+    m_pending[buffer] = m_frames;
+    m_frames++;
+
+    m_frameStart = m_clock.nsecsElapsed();
+}
+
+void FrameTimer::endFrame()
+{
+    if (m_frames == 0)
+        return;
+    timing(m_frames - 1).cpuFrame = (m_clock.nsecsElapsed() - m_frameStart) / 1.0e6f;
+}
+
+void FrameTimer::beginStage(int stage)
+{
+    int buffer = int((m_frames - 1) % FRAME_BUFFERS);
+    if (m_gpu && stage != FRAME_READ && buffer >= 0)
+    {
+        m_queries[buffer][stage].begin();
+        m_issued[buffer][stage] = true;
+    }
+    m_stageStart = m_clock.nsecsElapsed();
+}
+
+void FrameTimer::endStage(int stage)
+{
+    if (m_frames == 0)
+        return;
+    timing(m_frames - 1).cpu[stage] = (m_clock.nsecsElapsed() - m_stageStart) / 1.0e6f;
+
+    int buffer = int((m_frames - 1) % FRAME_BUFFERS);
+    if (m_issued[buffer][stage])
+        m_queries[buffer][stage].end();
+}
+
+// Интервал гистограммы: 0 - меньше 0.25 мс, k - [0.25*2^(k-1), 0.25*2^k)
+static int frameBin(float ms)
+{
+    if (ms < 0.25f)
+        return 0;
+    int bin = 1 + int(std::floor(std::log2(ms / 0.25f)));
+    return qMin(bin, FRAME_BINS - 1);
+}
+
+static void drawHistogram(QPainter &painter, const QRect &rect, const int *counts, const QString &label)
+{
+    int maxCount = 1;
+    for (int k = 0; k < FRAME_BINS; k++)
+        maxCount = qMax(maxCount, counts[k]);
+
+    int barWidth = rect.width() / FRAME_BINS;
+    int barArea = rect.height() - 14;
+    for (int k = 0; k < FRAME_BINS; k++)
+    {
+        int h = barArea * counts[k] / maxCount;
+        painter.fillRect(rect.left() + k * barWidth + 1, rect.top() + barArea - h,
+                         barWidth - 2, h, QColor(90, 200, 90));
+    }
+    painter.drawText(rect.left(), rect.bottom(), label);
+}
+
+/*************************************************************************
+  Оверлей поверх кадра: средние по этапам за окно FRAME_HISTORY кадров,
+  число не готовых вовремя запросов GPU и две гистограммы (процессор на paintGL и
+  GPU на оба прохода) в логарифмических интервалах от 0.25 мс до 2 с.
+ *************************************************************************/
+void FrameTimer::paint(QPainter &painter, int width)
+{
+    if (m_frames == 0)
+        return;
+
+    qint64 first = qMax(qint64(0), m_frames - FRAME_HISTORY);
+    int cpuCounts[FRAME_BINS] = {0};
+    int gpuCounts[FRAME_BINS] = {0};
+    float cpuMean[FRAME_STAGES] = {0.0f};
+    float gpuMean[FRAME_STAGES] = {0.0f};
+    int gpuFrames = 0;
+    float frameMean = 0.0f;
+
+    for (qint64 f = first; f < m_frames; f++)
+    {
+        const FrameTiming &t = timing(f);
+        cpuCounts[frameBin(t.cpuFrame)]++;
+        frameMean += t.cpuFrame;
+        for (int s = 0; s < FRAME_STAGES; s++)
+            cpuMean[s] += t.cpu[s];
+
+        if (t.gpu[FRAME_DEPTH] >= 0.0f && t.gpu[FRAME_MAIN] >= 0.0f)
+        {
+            gpuCounts[frameBin(t.gpu[FRAME_DEPTH] + t.gpu[FRAME_MAIN])]++;
+            for (int s = FRAME_DEPTH; s < FRAME_STAGES; s++)
+                gpuMean[s] += t.gpu[s];
+            gpuFrames++;
+        }
+    }
+
+    int frames = int(m_frames - first);
+    QStringList lines;
+    lines << QString("frame %1, window %2").arg(m_frames - 1).arg(frames);
+    QString cpuLine = QString("cpu %1 ms:").arg(frameMean / frames, 0, 'f', 2);
+    for (int s = 0; s < FRAME_STAGES; s++)
+        cpuLine += QString(" %1 %2").arg(stageNames[s]).arg(cpuMean[s] / frames, 0, 'f', 2);
+    lines << cpuLine;
+    if (!m_gpu)
+        lines << QString("gpu timer queries unavailable");
+    else if (gpuFrames == 0)
+        lines << QString("gpu waiting for results");
+    else
+    {
+        QString gpuLine = QString("gpu ms:");
+        for (int s = FRAME_DEPTH; s < FRAME_STAGES; s++)
+            gpuLine += QString(" %1 %2").arg(stageNames[s]).arg(gpuMean[s] / gpuFrames, 0, 'f', 2);
+        gpuLine += QString(", not ready %1").arg(m_dropped);
+        lines << gpuLine;
+    }
+    if (csvActive())
+        lines << QString("csv %1 from frame %2").arg(m_csvFile.fileName()).arg(m_csvFirst);
+
+    int hudWidth = qMin(width - 20, 360);
+    QRect panel(10, 10, hudWidth, 16 * lines.size() + 90);
+    painter.fillRect(panel, QColor(0, 0, 0, 160));
+    painter.setPen(Qt::white);
+    for (int i = 0; i < lines.size(); i++)
+        painter.drawText(panel.left() + 6, panel.top() + 16 * (i + 1), lines[i]);
+
+    int top = panel.top() + 16 * lines.size() + 8;
+    int half = (panel.width() - 18) / 2;
+    drawHistogram(painter, QRect(panel.left() + 6, top, half, 76), cpuCounts, "cpu frame");
+    drawHistogram(painter, QRect(panel.left() + 12 + half, top, half, 76), gpuCounts, "gpu frame");
+}
+
+/*************************************************************************
+  Запись кадров в CSV с текущего кадра до stopCsv, время в мс. Строка
+  кадра пишется, когда собраны его результаты GPU, так что в памяти
+  ничего не копится. Пустое поле GPU - запрос не готов вовремя или
+  недоступен.
+ *************************************************************************/
+bool FrameTimer::startCsv(const QString &fileName)
+{
+    stopCsv();
+
+    m_csvFile.setFileName(fileName);
+    if (!m_csvFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+        return false;
+
+    m_csv.setDevice(&m_csvFile);
+    m_csv << "frame,cpu_read_ms,cpu_depth_ms,cpu_main_ms,cpu_frame_ms,gpu_depth_ms,gpu_main_ms\n";
+    m_csvFirst = m_frames;
+    return true;
+}
+
+// Кадры, результаты GPU которых ещё не собраны, в файл не попадают
+void FrameTimer::stopCsv()
+{
+    if (!csvActive())
+        return;
+
+    m_csv.flush();
+    m_csv.setDevice(0);
+    m_csvFile.close();
+    m_csvFirst = -1;
+}
+
+bool FrameTimer::csvActive() const
+{
+    return m_csvFile.isOpen();
+}
+
+void FrameTimer::writeCsv(const FrameTiming &t)
+{
+    m_csv << t.frame;
+    for (int s = 0; s < FRAME_STAGES; s++)
+        m_csv << "," << t.cpu[s];
+    m_csv << "," << t.cpuFrame;
+    for (int s = FRAME_DEPTH; s < FRAME_STAGES; s++)
+    {
+        m_csv << ",";
+        if (t.gpu[s] >= 0.0f)
+            m_csv << t.gpu[s];
+    }
+    m_csv << "\n";
+}
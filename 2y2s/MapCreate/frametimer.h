@@ -0,0 +1,81 @@
+#ifndef FRAMETIMER_H
+#define FRAMETIMER_H
+
+#include <QOpenGLTimerQuery>
+#include <QElapsedTimer>
+#include <QVector>
+#include <QString>
+#include <QFile>
+#include <QTextStream>
+
+class QPainter;
+
+// Этапы кадра: чтение output.txt (только процессор), проход теней в
+// m_depthBuffer и основной проход на экран
+#define FRAME_READ 0
+#define FRAME_DEPTH 1
+#define FRAME_MAIN 2
+#define FRAME_STAGES 3
+
+// Наборы запросов GPU по кадрам: результат кадра k читается в кадре
+// k + FRAME_BUFFERS, когда он уже готов, и конвейер не ждёт
+#define FRAME_BUFFERS 2
+
+// Скользящее окно гистограммы (кольцевой буфер последних кадров) и её
+// интервалы (границы 0.25 мс * 2^k)
+#define FRAME_HISTORY 256
+#define FRAME_BINS 15
+
+struct FrameTiming {
+    qint64 frame;
+    float cpu[FRAME_STAGES];    // мс процессора на этап
+    float cpuFrame;             // мс процессора на весь paintGL
+    float gpu[FRAME_STAGES];    // мс GPU на этап, -1 - не измерено
+};
+
+class FrameTimer
+{
+public:
+    FrameTimer();
+
+    void init();
+    void destroy();
+
+    void beginFrame();
+    void endFrame();
+    void beginStage(int stage);
+    void endStage(int stage);
+
+    void paint(QPainter &painter, int width);
+    bool startCsv(const QString &fileName);
+    void stopCsv();
+    bool csvActive() const;
+    bool gpuAvailable() const;
+private:
+    void collect(int buffer);
+    FrameTiming &timing(qint64 frame);
+    void writeCsv(const FrameTiming &t);
+
+    QOpenGLTimerQuery m_queries[FRAME_BUFFERS][FRAME_STAGES];
+    qint64 m_pending[FRAME_BUFFERS];
+    bool m_issued[FRAME_BUFFERS][FRAME_STAGES];
+    bool m_gpu;
+    int m_dropped;
+
+    QElapsedTimer m_clock;
+    qint64 m_frameStart;
+    qint64 m_stageStart;
+
+    // Последние FRAME_HISTORY кадров, кадр f - в ячейке f % FRAME_HISTORY;
+    // m_frames - всего кадров с начала работы
+    QVector<FrameTiming> m_timings;
+    qint64 m_frames;
+
+    // Запись в CSV с кадра m_csvFirst: строка кадра пишется, когда
+    // собраны его результаты GPU
+    QFile m_csvFile;
+    QTextStream m_csv;
+    qint64 m_csvFirst;
+};
+
+#endif // FRAMETIMER_H
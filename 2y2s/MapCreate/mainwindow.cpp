@@ -1,4 +1,6 @@
 #include "mainwindow.h"
+#include "trace.h"
+#include <QPainter>
 
 MainWindow::MainWindow(QWidget *parent) :
     QOpenGLWidget(parent)
@@ -25,7 +27,12 @@ MainWindow::MainWindow(QWidget *parent) :
 
 MainWindow::~MainWindow()
 {
+    TRACE_SAVE("mapcreator_trace.json");
 
+    m_frameTimer.stopCsv();
+    makeCurrent();
+    m_frameTimer.destroy();
+    doneCurrent();
 }
 
 void MainWindow::initializeGL()
@@ -87,13 +94,15 @@ void MainWindow::initializeGL()
     vector1.push_back(-0.75);
     vector1.push_back(1.0);
 
-    initCube(vector);
+    initCube(vector, true);
 
 
     initCube(vector1);
 
     m_depthBuffer = new QOpenGLFramebufferObject(m_fbWidth, m_fbHeigth, QOpenGLFramebufferObject::Depth);
 
+    m_frameTimer.init();
+
     return;
 }
 
@@ -108,26 +117,44 @@ void MainWindow::resizeGL(int w, int h)
 
 void MainWindow::paintGL()
 {
-    //paint to frame buffer
-    m_depthBuffer->bind();
-
-    glViewport(0, 0, m_fbWidth, m_fbHeigth);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    TRACE_ZONE("paintGL");
+    m_frameTimer.beginFrame();
 
-    m_programDepth.bind();//
-    m_programDepth.setUniformValue("u_projectionLightMatrix", m_projectionLightMatrix);
-    m_programDepth.setUniformValue("u_shadowLightMatrix", m_shadowLightMatrix);
+    QVector<float> vector;
+    {
+        TRACE_ZONE("read output.txt");
+        m_frameTimer.beginStage(FRAME_READ);
+        QFile file("output.txt");
 
+        setDataToVector(allFileToString(file).split("\n"), vector);
+        m_frameTimer.endStage(FRAME_READ);
+    }
 
-    for (int i = 0; i < m_objects.size(); i++)
     {
-        m_objects[i]->draw(&m_programDepth, context()->functions());
-    }
+        TRACE_ZONE("depth pass");
+        m_frameTimer.beginStage(FRAME_DEPTH);
+        //paint to frame buffer
+        m_depthBuffer->bind();
 
+        glViewport(0, 0, m_fbWidth, m_fbHeigth);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    m_programDepth.release();
+        m_programDepth.bind();//
+        m_programDepth.setUniformValue("u_projectionLightMatrix", m_projectionLightMatrix);
+        m_programDepth.setUniformValue("u_shadowLightMatrix", m_shadowLightMatrix);
+        setModalUniforms(&m_programDepth, vector);
 
-    m_depthBuffer->release();
+        for (int i = 0; i < m_objects.size(); i++)
+        {
+            m_objects[i]->draw(&m_programDepth, context()->functions());
+        }
+
+
+        m_programDepth.release();
+
+        m_depthBuffer->release();
+        m_frameTimer.endStage(FRAME_DEPTH);
+    }
 
     GLuint texture = m_depthBuffer->texture();
 
@@ -137,6 +164,8 @@ void MainWindow::paintGL()
     glBindTexture(GL_TEXTURE_2D, texture);
 
     //paint on screen
+    TRACE_ZONE("main pass");
+    m_frameTimer.beginStage(FRAME_MAIN);
     glViewport(0, 0, width(), height());
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
@@ -145,11 +174,6 @@ void MainWindow::paintGL()
     modelViewMatrix.translate(0.0f, 0.0f, -0.0);
     modelViewMatrix.rotate(m_rotation);
 
-    QVector<float> vector;
-    QFile file("output.txt");
-
-    setDataToVector(allFileToString(file).split("\n"), vector);
-
     if (vector[0]==2)
         close();
 
@@ -161,12 +185,45 @@ void MainWindow::paintGL()
     m_shaderProgramm.setUniformValue("u_projectionLightMatrix", m_projectionLightMatrix);
     m_shaderProgramm.setUniformValue("u_shadowLightMatrix", m_shadowLightMatrix);
     m_shaderProgramm.setUniformValue("u_LightMatrix", m_LightMatrix);
-    m_shaderProgramm.setUniformValue("u_lightPower", 5.0f);
+    // vector[0] - видимая доля солнечного диска (0 - тень, 1 - Солнце открыто)
+    m_shaderProgramm.setUniformValue("u_lightPower", 5.0f * vector[0]);
+
+    // Отражённый Землёй свет: vector[31..39] - коэффициенты освещённости
+    // по сферическим функциям, vector[40..45] - оси X, Z локальной системы
+    GLfloat albedoSH[9];
+    QVector3D albedoX;
+    QVector3D albedoZ;
+    for (int i = 0; i < 9; i++)
+        albedoSH[i] = (vector.size() > 45) ? vector[31 + i] : 0.0f;
+    if (vector.size() > 45)
+    {
+        albedoX = modelViewMatrix.mapVector(QVector3D(vector[40], vector[41], vector[42]));
+        albedoZ = modelViewMatrix.mapVector(QVector3D(vector[43], vector[44], vector[45]));
+    }
+    m_shaderProgramm.setUniformValueArray("u_albedoSH", albedoSH, 9, 1);
+    m_shaderProgramm.setUniformValue("u_albedoX", albedoX);
+    m_shaderProgramm.setUniformValue("u_albedoZ", albedoZ);
+    m_shaderProgramm.setUniformValue("u_albedoPower", 5.0f);
+    setModalUniforms(&m_shaderProgramm, vector);
 
     for (int i = 0; i < m_objects.size(); i++)
     {
         m_objects[i]->draw(&m_shaderProgramm, context()->functions());
     }
+    m_frameTimer.endStage(FRAME_MAIN);
+    m_frameTimer.endFrame();
+
+    // Оверлей рисуется после замера и сбивает состояние GL, которое
+    // initializeGL задаёт один раз
+    if (m_showTimings)
+    {
+        QPainter painter(this);
+        m_frameTimer.paint(painter, width());
+        painter.end();
+
+        glEnable(GL_DEPTH_TEST);
+        glEnable(GL_CULL_FACE);
+    }
     return;
 }
 
@@ -187,18 +244,46 @@ void MainWindow::closeEvent(QCloseEvent *event)
 
 void MainWindow::keyPressEvent(QKeyEvent *event)
 {
+    TRACE_ZONE("keyPressEvent");
+
+    if (event->key() == Qt::Key_F1)
+    {
+        m_showTimings = !m_showTimings;
+        update();
+        return;
+    }
+
+    if (event->key() == Qt::Key_F2)
+    {
+        if (m_frameTimer.csvActive())
+            m_frameTimer.stopCsv();
+        else if (!m_frameTimer.startCsv("frametimes.csv"))
+            std::cout << "Error writing frametimes.csv" << std::endl;
+        return;
+    }
+
+    if (event->key() == Qt::Key_F3)
+    {
+        m_modeScale = (m_modeScale == 1.0f) ? MODE_EXAGGERATION : 1.0f;
+        update();
+        return;
+    }
+
    // while (1)
   //  {
-        QFile file("output.txt");
+        {
+            TRACE_ZONE("file shuffle");
+            QFile file("output.txt");
 
-        rewrite(allFileToString(file).split("\n"));
-        file.close();
+            rewrite(allFileToString(file).split("\n"));
+            file.close();
 
-        QFile file1 ("output.txt");
-        file1.remove();
-        file1.close();
+            QFile file1 ("output.txt");
+            file1.remove();
+            file1.close();
 
-        QFile::rename ( "data.txt", "output.txt" );
+            QFile::rename ( "data.txt", "output.txt" );
+        }
 
         QVector<float> V;
         QFile file2("output.txt");
@@ -207,55 +292,12 @@ void MainWindow::keyPressEvent(QKeyEvent *event)
         file2.close();
 
         QVector<VertexData> vertexes;
-
-        // Top side
-        vertexes.append(VertexData(QVector3D(V[7], V[8], V[9]), QVector2D(0.0f, 1.0f), QVector3D(0.0f, 1.0f, 0.0f)));
-        vertexes.append(VertexData(QVector3D(V[10], V[11], V[12]), QVector2D(0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f)));
-        vertexes.append(VertexData(QVector3D(V[13], V[14], V[15]), QVector2D(1.0f, 1.0f), QVector3D(0.0f, 1.0f, 0.0f)));
-        vertexes.append(VertexData(QVector3D(V[16], V[17], V[18]), QVector2D(1.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f)));
-
-
-        // Down side
-        vertexes.append(VertexData(QVector3D(V[25], V[26], V[27]), QVector2D(0.0f, 1.0f), QVector3D(0.0f, -1.0f, 0.0f)));
-        vertexes.append(VertexData(QVector3D(V[28], V[29], V[30]), QVector2D(0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f)));
-        vertexes.append(VertexData(QVector3D(V[19], V[20], V[21]), QVector2D(1.0f, 1.0f), QVector3D(0.0f, -1.0f, 0.0f)));
-        vertexes.append(VertexData(QVector3D(V[22], V[23], V[24]), QVector2D(1.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f)));
-
-        // Left side
-        vertexes.append(VertexData(QVector3D(V.at(7), V.at(8), V.at(9)), QVector2D(0.0f, 1.0f), QVector3D(-1.0f, 0.0f, 0.0f)));
-        vertexes.append(VertexData(QVector3D(V.at(19), V.at(20), V.at(21)), QVector2D(0.0f, 0.0f), QVector3D(-1.0f, 0.0f, 0.0f)));
-        vertexes.append(VertexData(QVector3D(V.at(10), V.at(11), V.at(12)), QVector2D(1.0f, 1.0f), QVector3D(-1.0f, 0.0f, 0.0f)));
-        vertexes.append(VertexData(QVector3D(V.at(22), V.at(23), V.at(24)), QVector2D(1.0f, 0.0f), QVector3D(-1.0f, 0.0f, 0.0f)));
-
-        // Right side
-        vertexes.append(VertexData(QVector3D(V.at(16), V.at(17), V.at(18)), QVector2D(0.0f, 1.0f), QVector3D(1.0f, 0.0f, 0.0f)));
-        vertexes.append(VertexData(QVector3D(V.at(28), V.at(29), V.at(30)), QVector2D(0.0f, 0.0f), QVector3D(1.0f, 0.0f, 0.0f)));
-        vertexes.append(VertexData(QVector3D(V.at(13), V.at(14), V.at(15)), QVector2D(1.0f, 1.0f), QVector3D(1.0f, 0.0f, 0.0f)));
-        vertexes.append(VertexData(QVector3D(V.at(25), V.at(26), V.at(27)), QVector2D(1.0f, 0.0f), QVector3D(1.0f, 0.0f, 0.0f)));
-
-        // Front side
-        vertexes.append(VertexData(QVector3D(V.at(10), V.at(11), V.at(12)), QVector2D(0.0f, 1.0f), QVector3D(0.0f, 0.0f, 1.0f)));
-        vertexes.append(VertexData(QVector3D(V.at(22), V.at(23), V.at(24)), QVector2D(0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f)));
-        vertexes.append(VertexData(QVector3D(V.at(16), V.at(17), V.at(18)), QVector2D(1.0f, 1.0f), QVector3D(0.0f, 0.0f, 1.0f)));
-        vertexes.append(VertexData(QVector3D(V.at(28), V.at(29), V.at(30)), QVector2D(1.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f)));
-
-        // Back side
-        vertexes.append(VertexData(QVector3D(V.at(13), V.at(14), V.at(15)), QVector2D(0.0f, 1.0f), QVector3D(0.0f, 0.0f, -1.0f)));
-        vertexes.append(VertexData(QVector3D(V.at(25), V.at(26), V.at(27)), QVector2D(0.0f, 0.0f), QVector3D(0.0f, 0.0f, -1.0f)));
-        vertexes.append(VertexData(QVector3D(V.at(7), V.at(8), V.at(9)), QVector2D(1.0f, 1.0f), QVector3D(0.0f, 0.0f, -1.0f)));
-        vertexes.append(VertexData(QVector3D(V.at(19), V.at(20), V.at(21)), QVector2D(1.0f, 0.0f), QVector3D(0.0f, 0.0f, -1.0f)));
-
         QVector<GLuint> indexes;
-        for (int i = 0; i < 24; i += 4){
-            indexes.append(i + 0);
-            indexes.append(i + 1);
-            indexes.append(i + 2);
-            indexes.append(i + 2);
-            indexes.append(i + 1);
-            indexes.append(i + 3);
-        }
+        appendPanel(V, vertexes, indexes);
 
-        m_objects.append(new Cube(vertexes, indexes, QImage("://panel.jpg")));
+        Cube *panel = new Cube(vertexes, indexes, QImage("://panel.jpg"));
+        panel->setFlexible(true);
+        m_objects.append(panel);
         paintGL();
 
         this->repaint();
@@ -296,9 +338,18 @@ void MainWindow::mousePressEvent(QMouseEvent *ke)
 }
 
 
+// Вершинные шейдеры берут прогиб панели (modeShape, deform и их
+// uniform-ы) из deform.vsh, который ставится перед их текстом
+QString MainWindow::vertexShader(const QString &aName)
+{
+    QFile deform("://deform.vsh");
+    QFile shader(aName);
+    return allFileToString(deform) + "\n" + allFileToString(shader);
+}
+
 void MainWindow::initShaders()
 {
-    if (!m_shaderProgramm.addShaderFromSourceFile(QOpenGLShader::Vertex, "://vshader.vsh"))
+    if (!m_shaderProgramm.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader("://vshader.vsh")))
         close();
 
     if (!m_shaderProgramm.addShaderFromSourceFile(QOpenGLShader::Fragment, "://fshader.fsh"))
@@ -310,7 +361,7 @@ void MainWindow::initShaders()
     if (!m_shaderProgramm.bind())
         close();
 
-    if (!m_programDepth.addShaderFromSourceFile(QOpenGLShader::Vertex, "://depth.vsh"))
+    if (!m_programDepth.addShaderFromSourceCode(QOpenGLShader::Vertex, vertexShader("://depth.vsh")))
         close();
 
     if (!m_programDepth.addShaderFromSourceFile(QOpenGLShader::Fragment, "://depth.fsh"))
@@ -321,7 +372,7 @@ void MainWindow::initShaders()
 
 }
 
-void MainWindow::initCube(QVector< float> &V)
+void MainWindow::initCube(QVector< float> &V, bool flexible)
 {
     QVector<VertexData> vertexes;
     std::cout<<V[0];
@@ -369,55 +420,136 @@ void MainWindow::initCube(QVector< float> &V)
     if(V[0]==2)
         close();
 
-    // Top side
-    vertexes.append(VertexData(QVector3D(V[7], V[8], V[9]), QVector2D(0.0f, 1.0f), QVector3D(0.0f, 1.0f, 0.0f)));
-    vertexes.append(VertexData(QVector3D(V[10], V[11], V[12]), QVector2D(0.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f)));
-    vertexes.append(VertexData(QVector3D(V[13], V[14], V[15]), QVector2D(1.0f, 1.0f), QVector3D(0.0f, 1.0f, 0.0f)));
-    vertexes.append(VertexData(QVector3D(V[16], V[17], V[18]), QVector2D(1.0f, 0.0f), QVector3D(0.0f, 1.0f, 0.0f)));
+    // В тени рисуются только нулевые вершины
+    QVector<GLuint> indexes;
+    if (V[0] == 0)
+    {
+        for (int i = 0; i < 24; i += 4){
+            indexes.append(i + 0);
+            indexes.append(i + 1);
+            indexes.append(i + 2);
+            indexes.append(i + 2);
+            indexes.append(i + 1);
+            indexes.append(i + 3);
+        }
+    }
+    else
+        appendPanel(V, vertexes, indexes);
 
+    Cube *cube = new Cube(vertexes, indexes, QImage("://panel.jpg"));
+    cube->setFlexible(flexible);
+    m_objects.append(cube);
+}
 
-    // Down side
-    vertexes.append(VertexData(QVector3D(V[25], V[26], V[27]), QVector2D(0.0f, 1.0f), QVector3D(0.0f, -1.0f, 0.0f)));
-    vertexes.append(VertexData(QVector3D(V[28], V[29], V[30]), QVector2D(0.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f)));
-    vertexes.append(VertexData(QVector3D(V[19], V[20], V[21]), QVector2D(1.0f, 1.0f), QVector3D(0.0f, -1.0f, 0.0f)));
-    vertexes.append(VertexData(QVector3D(V[22], V[23], V[24]), QVector2D(1.0f, 0.0f), QVector3D(0.0f, -1.0f, 0.0f)));
+/*************************************************************************
+  Грань панели сеткой PANEL_GRID x PANEL_GRID: вершины a, b, c, d в том же
+  порядке, что и у прежней грани из четырёх вершин (текстурные
+  координаты (0,1), (0,0), (1,1), (1,0)), обход треугольников тот же.
+  Мелкая сетка нужна, чтобы прогиб по упругим формам в вершинном шейдере
+  был виден внутри грани.
+ *************************************************************************/
+void MainWindow::appendFace(QVector<VertexData> &vertexes, QVector<GLuint> &indexes,
+                            QVector3D a, QVector3D b, QVector3D c, QVector3D d,
+                            QVector3D normal)
+{
+    GLuint base = vertexes.size();
 
-    // Left side
-    vertexes.append(VertexData(QVector3D(V.at(7), V.at(8), V.at(9)), QVector2D(0.0f, 1.0f), QVector3D(-1.0f, 0.0f, 0.0f)));
-    vertexes.append(VertexData(QVector3D(V.at(19), V.at(20), V.at(21)), QVector2D(0.0f, 0.0f), QVector3D(-1.0f, 0.0f, 0.0f)));
-    vertexes.append(VertexData(QVector3D(V.at(10), V.at(11), V.at(12)), QVector2D(1.0f, 1.0f), QVector3D(-1.0f, 0.0f, 0.0f)));
-    vertexes.append(VertexData(QVector3D(V.at(22), V.at(23), V.at(24)), QVector2D(1.0f, 0.0f), QVector3D(-1.0f, 0.0f, 0.0f)));
+    for (int i = 0; i <= PANEL_GRID; i++)
+    {
+        float s = float(i) / PANEL_GRID;
+        for (int j = 0; j <= PANEL_GRID; j++)
+        {
+            float t = float(j) / PANEL_GRID;
+            QVector3D p = (1 - s) * ((1 - t) * b + t * a) + s * ((1 - t) * d + t * c);
+            vertexes.append(VertexData(p, QVector2D(s, t), normal));
+        }
+    }
 
-    // Right side
-    vertexes.append(VertexData(QVector3D(V.at(16), V.at(17), V.at(18)), QVector2D(0.0f, 1.0f), QVector3D(1.0f, 0.0f, 0.0f)));
-    vertexes.append(VertexData(QVector3D(V.at(28), V.at(29), V.at(30)), QVector2D(0.0f, 0.0f), QVector3D(1.0f, 0.0f, 0.0f)));
-    vertexes.append(VertexData(QVector3D(V.at(13), V.at(14), V.at(15)), QVector2D(1.0f, 1.0f), QVector3D(1.0f, 0.0f, 0.0f)));
-    vertexes.append(VertexData(QVector3D(V.at(25), V.at(26), V.at(27)), QVector2D(1.0f, 0.0f), QVector3D(1.0f, 0.0f, 0.0f)));
+    for (int i = 0; i < PANEL_GRID; i++)
+    {
+        for (int j = 0; j < PANEL_GRID; j++)
+        {
+            GLuint A = base + i * (PANEL_GRID + 1) + j + 1;
+            GLuint B = base + i * (PANEL_GRID + 1) + j;
+            GLuint C = base + (i + 1) * (PANEL_GRID + 1) + j + 1;
+            GLuint D = base + (i + 1) * (PANEL_GRID + 1) + j;
+            indexes.append(A);
+            indexes.append(B);
+            indexes.append(C);
+            indexes.append(C);
+            indexes.append(B);
+            indexes.append(D);
+        }
+    }
+}
 
-    // Front side
-    vertexes.append(VertexData(QVector3D(V.at(10), V.at(11), V.at(12)), QVector2D(0.0f, 1.0f), QVector3D(0.0f, 0.0f, 1.0f)));
-    vertexes.append(VertexData(QVector3D(V.at(22), V.at(23), V.at(24)), QVector2D(0.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f)));
-    vertexes.append(VertexData(QVector3D(V.at(16), V.at(17), V.at(18)), QVector2D(1.0f, 1.0f), QVector3D(0.0f, 0.0f, 1.0f)));
-    vertexes.append(VertexData(QVector3D(V.at(28), V.at(29), V.at(30)), QVector2D(1.0f, 0.0f), QVector3D(0.0f, 0.0f, 1.0f)));
+// Шесть граней параллелепипеда по вершинам V[7..30] из output.txt
+void MainWindow::appendPanel(QVector<float> &V, QVector<VertexData> &vertexes, QVector<GLuint> &indexes)
+{
+    QVector3D p[8];
+    for (int i = 0; i < 8; i++)
+        p[i] = QVector3D(V.at(7 + 3 * i), V.at(8 + 3 * i), V.at(9 + 3 * i));
 
+    // Top side
+    appendFace(vertexes, indexes, p[0], p[1], p[2], p[3], QVector3D(0.0f, 1.0f, 0.0f));
+    // Down side
+    appendFace(vertexes, indexes, p[6], p[7], p[4], p[5], QVector3D(0.0f, -1.0f, 0.0f));
+    // Left side
+    appendFace(vertexes, indexes, p[0], p[4], p[1], p[5], QVector3D(-1.0f, 0.0f, 0.0f));
+    // Right side
+    appendFace(vertexes, indexes, p[3], p[7], p[2], p[6], QVector3D(1.0f, 0.0f, 0.0f));
+    // Front side
+    appendFace(vertexes, indexes, p[1], p[5], p[3], p[7], QVector3D(0.0f, 0.0f, 1.0f));
     // Back side
-    vertexes.append(VertexData(QVector3D(V.at(13), V.at(14), V.at(15)), QVector2D(0.0f, 1.0f), QVector3D(0.0f, 0.0f, -1.0f)));
-    vertexes.append(VertexData(QVector3D(V.at(25), V.at(26), V.at(27)), QVector2D(0.0f, 0.0f), QVector3D(0.0f, 0.0f, -1.0f)));
-    vertexes.append(VertexData(QVector3D(V.at(7), V.at(8), V.at(9)), QVector2D(1.0f, 1.0f), QVector3D(0.0f, 0.0f, -1.0f)));
-    vertexes.append(VertexData(QVector3D(V.at(19), V.at(20), V.at(21)), QVector2D(1.0f, 0.0f), QVector3D(0.0f, 0.0f, -1.0f)));
+    appendFace(vertexes, indexes, p[2], p[6], p[0], p[4], QVector3D(0.0f, 0.0f, -1.0f));
+}
 
+/*************************************************************************
+  Упругие формы панели для шейдеров. После 46 чисел строки output.txt
+  идут число форм и для каждой beta, sigma и амплитуда прогиба. Система
+  панели - по её вершинам: d2, d4, d6, d8 - кромка у шарнира, d1, d3,
+  d5, d7 - дальняя, d1 -> d3 - поперёк размаха, d5 -> d1 - нормаль.
+  Прогиб - физический; для отладки F3 увеличивает его в
+  MODE_EXAGGERATION раз.
+ *************************************************************************/
+void MainWindow::setModalUniforms(QOpenGLShaderProgram *program, QVector<float> &V)
+{
+    int count = 0;
+    GLfloat beta[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    GLfloat sigma[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    GLfloat amp[4] = {0.0f, 0.0f, 0.0f, 0.0f};
 
-    QVector<GLuint> indexes;
-    for (int i = 0; i < 24; i += 4){
-        indexes.append(i + 0);
-        indexes.append(i + 1);
-        indexes.append(i + 2);
-        indexes.append(i + 2);
-        indexes.append(i + 1);
-        indexes.append(i + 3);
+    if (V.size() > 46 && V[0] != 0)
+    {
+        count = qMin(int(V[46]), 4);
+        if (V.size() < 47 + 3 * count)
+            count = 0;
+        for (int k = 0; k < count; k++)
+        {
+            beta[k] = V[47 + 3 * k];
+            sigma[k] = V[48 + 3 * k];
+            amp[k] = m_modeScale * V[49 + 3 * k];
+        }
+    }
+
+    QVector3D p[8];
+    if (V.size() > 30)
+    {
+        for (int i = 0; i < 8; i++)
+            p[i] = QVector3D(V.at(7 + 3 * i), V.at(8 + 3 * i), V.at(9 + 3 * i));
     }
 
-    m_objects.append(new Cube(vertexes, indexes, QImage("://panel.jpg")));
+    QVector3D hinge = 0.25f * (p[1] + p[3] + p[5] + p[7]);
+    QVector3D tip = 0.25f * (p[0] + p[2] + p[4] + p[6]);
+
+    program->setUniformValue("u_panelOrigin", hinge);
+    program->setUniformValue("u_panelSpan", tip - hinge);
+    program->setUniformValue("u_panelAcross", (p[2] - p[0]).normalized());
+    program->setUniformValue("u_panelNormal", (p[0] - p[4]).normalized());
+    program->setUniformValue("u_modeCount", count);
+    program->setUniformValueArray("u_modeBeta", beta, 4, 1);
+    program->setUniformValueArray("u_modeSigma", sigma, 4, 1);
+    program->setUniformValueArray("u_modeAmp", amp, 4, 1);
 }
 
 
@@ -27,6 +27,12 @@
 #include <QMouseEvent>
 #include <QMessageBox>
 #include <cube.h>
+#include "frametimer.h"
+
+// Разбиение граней панели и увеличение прогиба упругих форм в рисунке
+// для отладки (F3); по умолчанию прогиб - физический
+#define PANEL_GRID 16
+#define MODE_EXAGGERATION 1000.0f
 
 class Cube;
 class QOpenGLFramebufferObject;
@@ -49,8 +55,14 @@ protected:
     void mouseMoveEvent(QMouseEvent *event) override;
     void keyPressEvent(QKeyEvent *ke);
 
+    QString vertexShader(const QString &aName);
     void initShaders();
-    void initCube(QVector< float> &aVector);
+    void initCube(QVector< float> &aVector, bool flexible = false);
+    void appendFace(QVector<VertexData> &vertexes, QVector<GLuint> &indexes,
+                    QVector3D a, QVector3D b, QVector3D c, QVector3D d,
+                    QVector3D normal);
+    void appendPanel(QVector<float> &V, QVector<VertexData> &vertexes, QVector<GLuint> &indexes);
+    void setModalUniforms(QOpenGLShaderProgram *program, QVector<float> &V);
     void setDataToVector(const QStringList &aStringList,
                          QVector< float> &aVector);
     const QString allFileToString(QFile &aFile);
@@ -78,6 +90,14 @@ private:
     quint32 m_fbWidth;
 
     int counter = 0;
+
+    // Время кадра по этапам: F1 - оверлей, F2 - запись в frametimes.csv
+    // с этого кадра до следующего F2
+    FrameTimer m_frameTimer;
+    bool m_showTimings = false;
+
+    // Множитель прогиба упругих форм: 1 или MODE_EXAGGERATION (F3)
+    float m_modeScale = 1.0f;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,362 @@
+#include "detector.h"
+#include "adaptive.h"
+#include "conservation.h"
+#include "checkpoint.h"
+#include "adcs.h"
+
+#include <vector>
+
+mtl::dense2D<double> Ilock(3,3);
+
+mtl::dense2D<double> Ilockinv(3,3);
+
+// Порог по скоростям панели, ниже которого панель считается неподвижной
+double ratetol = 1e-4;
+
+// Панель стопорится, только если за это время (с) возбуждение шарнира
+// не наберёт ratetol
+double lockhorizon = 100.0;
+
+// Через сколько шагов в режиме твёрдого тела проверять возбуждение шарнира
+int adaptivecheck = 10;
+
+int switches = 0;
+
+// Допуск проверки -adaptivecheck: расхождение углов панели (м) с полной
+// моделью на всём прогоне. На scenarios/locking.scn с -srp - около 1.2 см
+double adaptivetol = 0.02;
+
+// Скорость, которую набрала бы панель с момента стопорения, и
+// скорость её роста (возбуждение шарнира за секунду)
+double lockedrate = 0.0;
+
+double lockedexcitation = 0.0;
+
+// Ускорения в шарнире на момент последней проверки, набранные с момента
+// стопорения скорости и углы панели - их она получает, когда её отпускают
+double lockedaccel[2] = {0.0, 0.0};
+
+double lockedrates[2] = {0.0, 0.0};
+
+double lockedangles[2] = {0.0, 0.0};
+
+// Время в полной модели с тех пор, как панель отпустили. Снова
+// стопорится она не раньше, чем через lockhorizon: возбуждение, которое
+// её отпустило, за это время набрало бы ratetol, хотя скорость панели
+// после стопорения нулевая
+double unlockedtime = 0.0;
+
+/*************************************************************************
+  Правая часть для спутника с застопоренной панелью (flag=2): твёрдое
+  тело с тензором инерции Ilock, который считается в lockpanel, под
+  тем же внешним моментом, что и в полной модели (bodytorque).
+  Углы панели не меняются, их скорости равны нулю.
+ *************************************************************************/
+void ffrigid(double x, double * y, double * f)
+{
+    using namespace mtl;
+
+    // Кинетический момент маховиков на момент x (для bodytorque)
+    if (adcs)
+        adcswheels(x);
+
+    dense_vector <double> w(3);
+    w = omega1(y);
+
+    dense_vector <double> tau(3);
+    tau = -cross(w, dense_vector <double>(Ilock * w));
+
+    double g[5];
+    bodytorque(y, tau, g);
+
+    dense_vector <double> dw(3);
+    dw = Ilockinv * tau;
+
+    int i;
+    for (i=0;i<3;i++)
+    {
+        f[i]=dw(i);
+    }
+
+    dense_vector <double> dq4(4);
+    dq4 = dq(y);
+    for (i=3;i<7;i++)
+    {
+        f[i]=dq4(i-3);
+    }
+
+    f[7] = 0.0;
+    f[8] = 0.0;
+    f[9] = 0.0;
+    f[10] = 0.0;
+}
+
+// Угловые ускорения в шарнире по полной модели при нулевых скоростях
+// панели
+static void hingeacceleration(double * y, double * a)
+{
+    double yt[11];
+    double f[11];
+
+    int i;
+    for (i=0;i<11;i++)
+        yt[i]=y[i];
+    yt[9]=0.0;
+    yt[10]=0.0;
+
+    ff(0, yt, f, 1);
+
+    a[0]=f[9];
+    a[1]=f[10];
+}
+
+/*************************************************************************
+  Насколько раскачается шарнир за время h, если его отпустить: угловое
+  ускорение в шарнире, умноженное на h.
+ *************************************************************************/
+double hingeexcitation(double * y, double h)
+{
+    double a[2];
+    hingeacceleration(y, a);
+
+    return fabs(h) * (fabs(a[0]) > fabs(a[1]) ? fabs(a[0]) : fabs(a[1]));
+}
+
+// Возбуждение шарнира застопоренной панели (раз в adaptivecheck шагов)
+static void lockedcheck(double * y)
+{
+    hingeacceleration(y, lockedaccel);
+    lockedexcitation = fabs(lockedaccel[0]) > fabs(lockedaccel[1]) ? fabs(lockedaccel[0]) : fabs(lockedaccel[1]);
+}
+
+/*************************************************************************
+  Событие стопорения панели. Тензор инерции системы - левый верхний блок
+  S(y): I1 + J2 + перенос осей для панели. Угловая скорость спутника
+  выбирается так, чтобы сохранился кинетический момент системы вместе с
+  движением панели, после чего скорости панели обнуляются.
+ *************************************************************************/
+void lockpanel(double * y)
+{
+    using namespace mtl;
+
+    dense2D<double> A(5, 5);
+    A = S(y);
+
+    int i, j;
+    for (i=0;i<3;i++)
+    {
+        for (j=0;j<3;j++)
+            Ilock(i,j)=A(i,j);
+    }
+    Ilockinv = mat::inv(Ilock);
+
+    dense_vector <double> u(5);
+    for (i=0;i<3;i++)
+        u(i)=y[i];
+    u(3)=y[9];
+    u(4)=y[10];
+
+    dense_vector <double> H(3);
+    for (i=0;i<3;i++)
+    {
+        H(i)=0.0;
+        for (j=0;j<5;j++)
+            H(i)+=A(i,j)*u(j);
+    }
+
+    dense_vector <double> w(3);
+    w = Ilockinv * H;
+
+    for (i=0;i<3;i++)
+        y[i]=w(i);
+    y[9]=0.0;
+    y[10]=0.0;
+}
+
+/*************************************************************************
+  Событие отпускания панели: она получает углы и скорости, которые
+  набрала бы под возбуждением шарнира с момента стопорения, а угловая
+  скорость спутника выбирается так, чтобы кинетический момент системы
+  Ilock*omega сохранился (обратное к lockpanel).
+ *************************************************************************/
+static void unlockpanel(double * y)
+{
+    using namespace mtl;
+
+    dense_vector <double> H(3);
+    H = Ilock * omega1(y);
+
+    y[7]+=lockedangles[0];
+    y[8]+=lockedangles[1];
+    y[9]=lockedrates[0];
+    y[10]=lockedrates[1];
+
+    dense2D<double> A(5, 5);
+    A = S(y);
+
+    dense2D<double> B(3, 3);
+    int i, j;
+    for (i=0;i<3;i++)
+    {
+        H(i)-=A(i,3)*y[9] + A(i,4)*y[10];
+        for (j=0;j<3;j++)
+            B(i,j)=A(i,j);
+    }
+
+    dense_vector <double> w(3);
+    w = mat::inv(B) * H;
+    for (i=0;i<3;i++)
+        y[i]=w(i);
+}
+
+// Панель можно застопорить: прошло lockhorizon с тех пор, как её
+// отпустили (held), скорости в шарнире и его возбуждение за lockhorizon
+// ниже ratetol
+static int lockable(double * y, double held)
+{
+    return held >= lockhorizon && fabs(y[9]) < ratetol && fabs(y[10]) < ratetol
+        && hingeexcitation(y, lockhorizon) < ratetol;
+}
+
+/*************************************************************************
+  Рунге-Кутта с переключением модели. flag на входе и выходе - текущая
+  модель: 1 - полная модель с панелью на шарнире, 2 - твёрдое тело.
+
+  В полной модели панель стопорится, когда скорости в шарнире и его
+  возбуждение за lockhorizon становятся ниже ratetol: шаг, в конце
+  которого это так, повторяется из начальной точки с долей шага,
+  найденной делением пополам (как касание в solvesystemstops), и
+  остаток шага идёт в модели твёрдого тела.
+
+  В модели твёрдого тела панель отпускается, когда скорость, которую
+  набрал бы шарнир с момента стопорения, превышает ratetol (и после этого
+  lockhorizon не стопорится); набранные углы и скорости она получает в
+  unlockpanel. Возбуждение
+  шарнира пересчитывается раз в adaptivecheck шагов и между проверками
+  постоянно, так что скорость растёт линейно и момент, когда она
+  достигает ratetol, находится сразу; с него остаток шага идёт в полной
+  модели.
+ *************************************************************************/
+void solvesystemadaptive(int n, double x, double x1, int steps, double * y, int * flag)
+{
+    double h = (x1-x)/steps;
+    std::vector<double> y0(n);
+    std::vector<double> yt(n);
+
+    int i, j;
+    for(i = 0; i < steps; i++)
+    {
+        double t = x+i*h;
+        double rest = h;
+
+        if (*flag == 2 && i % adaptivecheck == 0)
+            lockedcheck(y);
+
+        while (rest > 0)
+        {
+            if (*flag == 2)
+            {
+                double dt = rest;
+                int unlock = 0;
+                if (lockedrate + lockedexcitation*rest > ratetol)
+                {
+                    dt = (ratetol - lockedrate)/lockedexcitation;
+                    unlock = 1;
+                }
+
+                if (dt > 0)
+                    step(n, t, dt, y, 2);
+                lockedrate += lockedexcitation*dt;
+                for (j=0;j<2;j++)
+                {
+                    lockedangles[j] += (lockedrates[j] + 0.5*lockedaccel[j]*dt)*dt;
+                    lockedrates[j] += lockedaccel[j]*dt;
+                }
+                t += dt;
+                rest -= dt;
+
+                if (!unlock)
+                    break;
+                unlockpanel(y);
+                *flag = 1;
+                unlockedtime = 0.0;
+                switches++;
+                continue;
+            }
+
+            for (j=0;j<n;j++)
+                y0[j]=y[j];
+
+            step(n, t, rest, y, 1);
+            if (!lockable(y, unlockedtime + rest))
+            {
+                unlockedtime += rest;
+                break;
+            }
+
+            // Панель успокоилась внутри шага: ищем момент
+            double lo = 0.0;
+            double hi = rest;
+            while (hi - lo > 1e-9 * h)
+            {
+                double mid = 0.5*(lo + hi);
+                for (j=0;j<n;j++)
+                    yt[j]=y0[j];
+                step(n, t, mid, &yt[0], 1);
+
+                if (lockable(&yt[0], unlockedtime + mid))
+                    hi = mid;
+                else
+                    lo = mid;
+            }
+
+            for (j=0;j<n;j++)
+                y[j]=y0[j];
+            step(n, t, hi, y, 1);
+
+            lockpanel(y);
+            lockedrate = 0.0;
+            for (j=0;j<2;j++)
+            {
+                lockedrates[j] = 0.0;
+                lockedangles[j] = 0.0;
+            }
+            lockedcheck(y);
+            *flag = 2;
+            switches++;
+
+            t += hi;
+            rest -= hi;
+        }
+
+        if (monitor)
+            monitorstep(y, *flag);
+    }
+}
+
+// Состояние переключения моделей для контрольной точки (тензор
+// застопоренной панели - на случай, если она застопорена сейчас)
+void adaptivecheckpoint(Checkpoint & ck)
+{
+    ckio(ck, switches);
+    ckio(ck, &lockedrate, 1);
+    ckio(ck, &lockedexcitation, 1);
+    ckio(ck, lockedaccel, 2);
+    ckio(ck, lockedrates, 2);
+    ckio(ck, lockedangles, 2);
+    ckio(ck, &unlockedtime, 1);
+
+    int i, j;
+    for (i=0;i<3;i++)
+    {
+        for (j=0;j<3;j++)
+        {
+            double a = Ilock(i,j);
+            double b = Ilockinv(i,j);
+            ckio(ck, &a, 1);
+            ckio(ck, &b, 1);
+            Ilock(i,j) = a;
+            Ilockinv(i,j) = b;
+        }
+    }
+}
@@ -0,0 +1,30 @@
+#ifndef ADAPTIVE_H
+#define ADAPTIVE_H
+
+#include <boost/numeric/mtl/mtl.hpp>
+
+extern mtl::dense2D<double> Ilock;
+
+extern mtl::dense2D<double> Ilockinv;
+
+extern double ratetol;
+
+extern double lockhorizon;
+
+extern int adaptivecheck;
+
+extern double unlockedtime;
+
+extern int switches;
+
+extern double adaptivetol;
+
+void ffrigid(double x, double * y, double * f);
+double hingeexcitation(double * y, double h);
+void lockpanel(double * y);
+void solvesystemadaptive(int n, double x, double x1, int steps, double * y, int * flag);
+
+struct Checkpoint;
+void adaptivecheckpoint(Checkpoint & ck);
+
+#endif // ADAPTIVE_H
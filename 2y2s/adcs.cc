@@ -0,0 +1,190 @@
+#include "detector.h"
+#include "adcs.h"
+#include "checkpoint.h"
+
+// Замкнутый контур ориентации: три маховика по осям связанной системы и
+// ПД-регулятор по ошибке кватерниона
+int adcs = 0;
+
+// Частота регулятора (Гц) - не зависит от шага интегрирования
+double adcsrate = 10.0;
+
+// Коэффициенты регулятора: момент -kp*dq - kd*omega
+double adcskp = 0.7;
+
+double adcskd = 5.0;
+
+// Ограничения маховиков: момент (Н*м) и кинетический момент (Н*м*с)
+double adcsmaxtorque = 0.1;
+
+double adcsmaxmomentum = 5.0;
+
+// Требуемая ориентация (в тех же обозначениях, что y[3..6])
+double adcsref[4] = {0.0, 0.0, 0.0, 1.0};
+
+// Кинетический момент маховиков в текущий момент и момент двигателей,
+// удерживаемый до следующего такта
+double wheelmomentum[3] = {0.0, 0.0, 0.0};
+
+double wheeltorque[3] = {0.0, 0.0, 0.0};
+
+long adcsticks = 0;
+
+// Начало расписания, момент последнего такта, кинетический момент на
+// нём и время следующего такта
+static double adcsstart = 0.0;
+static double adcslast = 0.0;
+static double adcsmomentum[3] = {0.0, 0.0, 0.0};
+static double adcsnext = 0.0;
+
+/*************************************************************************
+  Ошибка ориентации dq = q * ref^-1 (умножение кватернионов в том же
+  соглашении, что и кинематика dq = 0.5 OMEGA q, скалярная часть
+  последняя). Векторная часть dq - ошибка в связанной системе.
+ *************************************************************************/
+static void adcsdelta(double * y, double * d)
+{
+    double * p = y + 3;
+    double c1 = -adcsref[0];
+    double c2 = -adcsref[1];
+    double c3 = -adcsref[2];
+    double c4 = adcsref[3];
+
+    d[0] = p[3]*c1 + p[2]*c2 - p[1]*c3 + p[0]*c4;
+    d[1] = -p[2]*c1 + p[3]*c2 + p[0]*c3 + p[1]*c4;
+    d[2] = p[1]*c1 - p[0]*c2 + p[3]*c3 + p[2]*c4;
+    d[3] = -p[0]*c1 - p[1]*c2 - p[2]*c3 + p[3]*c4;
+}
+
+void adcsreset(double x)
+{
+    int i;
+    for (i=0;i<3;i++)
+    {
+        wheelmomentum[i] = 0.0;
+        wheeltorque[i] = 0.0;
+        adcsmomentum[i] = 0.0;
+    }
+    adcsticks = 0;
+    adcsstart = x;
+    adcslast = x;
+    adcsnext = x;
+}
+
+/*************************************************************************
+  Такт регулятора в момент x: требуемый момент на корпус
+  u = -kp sign(dq4) dqv - kd omega с ограничением по оси; маховики
+  создают его, раскручиваясь в обратную сторону, и не раскручиваются
+  дальше предела кинетического момента. Момент держится до следующего
+  такта. Только массивы double - без выделения памяти.
+ *************************************************************************/
+void adcscontrol(double x, double * y)
+{
+    adcswheels(x);
+
+    double d[4];
+    adcsdelta(y, d);
+    double sign = (d[3] < 0) ? -1.0 : 1.0;
+
+    int i;
+    for (i=0;i<3;i++)
+    {
+        double u = -adcskp*sign*d[i] - adcskd*y[i];
+        if (u > adcsmaxtorque)
+            u = adcsmaxtorque;
+        if (u < -adcsmaxtorque)
+            u = -adcsmaxtorque;
+
+        double tw = -u;
+        if ((wheelmomentum[i] >= adcsmaxmomentum && tw > 0) ||
+            (wheelmomentum[i] <= -adcsmaxmomentum && tw < 0))
+            tw = 0.0;
+
+        wheeltorque[i] = tw;
+        adcsmomentum[i] = wheelmomentum[i];
+    }
+
+    adcslast = x;
+    adcsticks++;
+}
+
+/*************************************************************************
+  Кинетический момент маховиков в момент x: при постоянном моменте
+  двигателей он меняется линейно от последнего такта, так что в вектор
+  состояния его добавлять не нужно.
+ *************************************************************************/
+void adcswheels(double x)
+{
+    int i;
+    for (i=0;i<3;i++)
+        wheelmomentum[i] = adcsmomentum[i] + wheeltorque[i]*(x - adcslast);
+}
+
+/*************************************************************************
+  Момент маховиков на корпус для v(y): реакция двигателей -tw и
+  гироскопический член -omega x h.
+ *************************************************************************/
+void adcstorque(double * y, double * tau)
+{
+    double * h = wheelmomentum;
+
+    tau[0] = -wheeltorque[0] - (y[1]*h[2] - y[2]*h[1]);
+    tau[1] = -wheeltorque[1] - (y[2]*h[0] - y[0]*h[2]);
+    tau[2] = -wheeltorque[2] - (y[0]*h[1] - y[1]*h[0]);
+}
+
+// Угол ошибки ориентации (рад)
+double adcserror(double * y)
+{
+    double d[4];
+    adcsdelta(y, d);
+
+    double n = sqrt(d[0]*d[0] + d[1]*d[1] + d[2]*d[2] + d[3]*d[3]);
+    double c = fabs(d[3])/n;
+    if (c > 1.0)
+        c = 1.0;
+
+    return 2.0*acos(c);
+}
+
+/*************************************************************************
+  Интегрирование с регулятором: отрезок [x, x1] режется по тактам
+  регулятора, шаг внутри куска не больше (x1-x)/steps. Такты считаются
+  по номеру (adcsstart + adcsticks/adcsrate), а не накоплением периода,
+  так что расписание не уплывает на длинных прогонах. Состояние не
+  копируется и не перевыделяется.
+ *************************************************************************/
+void solvesystemadcs(int n, double x, double x1, int steps, double * y, int flag)
+{
+    double h = (x1 - x)/steps;
+    double eps = 1e-9*h;
+
+    while (x < x1 - eps)
+    {
+        if (x >= adcsnext - eps)
+        {
+            adcscontrol(x, y);
+            adcsnext = adcsstart + adcsticks/adcsrate;
+        }
+
+        double xe = (adcsnext < x1) ? adcsnext : x1;
+        int k = (int)ceil((xe - x)/h - 1e-9);
+        if (k < 1)
+            k = 1;
+
+        solvesystemrungekutta(n, x, xe, k, y, flag);
+        x = xe;
+    }
+}
+
+// Маховики и такты регулятора для контрольной точки
+void adcscheckpoint(Checkpoint & ck)
+{
+    ckio(ck, wheelmomentum, 3);
+    ckio(ck, wheeltorque, 3);
+    ckio(ck, adcsmomentum, 3);
+    ckio(ck, adcsticks);
+    ckio(ck, &adcsstart, 1);
+    ckio(ck, &adcslast, 1);
+    ckio(ck, &adcsnext, 1);
+}
@@ -0,0 +1,34 @@
+#ifndef ADCS_H
+#define ADCS_H
+
+extern int adcs;
+
+extern double adcsrate;
+
+extern double adcskp;
+
+extern double adcskd;
+
+extern double adcsmaxtorque;
+
+extern double adcsmaxmomentum;
+
+extern double adcsref[4];
+
+extern double wheelmomentum[3];
+
+extern double wheeltorque[3];
+
+extern long adcsticks;
+
+void adcsreset(double x);
+void adcscontrol(double x, double * y);
+void adcswheels(double x);
+void adcstorque(double * y, double * tau);
+double adcserror(double * y);
+void solvesystemadcs(int n, double x, double x1, int steps, double * y, int flag);
+
+struct Checkpoint;
+void adcscheckpoint(Checkpoint & ck);
+
+#endif // ADCS_H
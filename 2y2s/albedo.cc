@@ -0,0 +1,402 @@
+#include "detector.h"
+#include "albedo.h"
+#include "binfile.h"
+
+#include <vector>
+#include <chrono>
+
+// Альбедо Земли (ламбертовский отражатель)
+double albedo = 0.3;
+
+// Таблица: высота (логарифмическая сетка) x фазовый угол x 9 коэффициентов
+static int albedonh = 32;
+static int albedonphi = 32;
+static double albedohmin = 100000.0;
+static double albedohmax = 40000000.0;
+static std::vector<float> albedotable;
+
+// Наибольший размер таблицы из файла (узлов высота x угол)
+#define ALBEDO_MAXNODES (1 << 20)
+
+// Число узлов квадратуры по углу от надира и по азимуту
+#define ALBEDO_NQ 96
+
+/*************************************************************************
+  Локальная система спутника: Z - на центр Земли, Солнце в плоскости XZ
+  с положительной проекцией на X. h - высота, phi - фазовый угол
+  Солнце-Земля-спутник (угол между направлением на Солнце и зенитом -Z).
+
+  Яркость точки земного шара P, видимой по направлению w:
+      L = albedo/pi * max(0, (N_P, s)),
+  освещённость площадки с нормалью n:
+      E(n) = интеграл по видимой шапке L(w) max(0, (n, w)) dw
+  в долях солнечной постоянной.
+ *************************************************************************/
+static double capradiance(double d, double st, double ct, double sp, double cp,
+                          double sx, double sz, double * w)
+{
+    w[0] = st*cp;
+    w[1] = st*sp;
+    w[2] = ct;
+
+    // Пересечение луча со сферой радиуса R, центр Земли в точке d*Z
+    double disc = (double)R*R - d*d*st*st;
+    double t = d*ct - sqrt(disc > 0 ? disc : 0.0);
+
+    double nx = t*w[0]/R;
+    double nz = (t*w[2] - d)/R;
+
+    double cs = nx*sx + nz*sz;
+    return (cs > 0) ? albedo/M_PI*cs : 0.0;
+}
+
+// Вещественные сферические функции до второго порядка
+static void shbasis(double x, double y, double z, double * b)
+{
+    b[0] = 0.282095;
+    b[1] = 0.488603*y;
+    b[2] = 0.488603*z;
+    b[3] = 0.488603*x;
+    b[4] = 1.092548*x*y;
+    b[5] = 1.092548*y*z;
+    b[6] = 0.315392*(3.0*z*z - 1.0);
+    b[7] = 1.092548*x*z;
+    b[8] = 0.546274*(x*x - y*y);
+}
+
+/*************************************************************************
+  Коэффициенты освещённости E(n) по сферическим функциям до второго
+  порядка: яркость шапки раскладывается по Y_lm и сворачивается с
+  косинусом (Ramamoorthi, Hanrahan): E_lm = A_l L_lm,
+  A_0 = pi, A_1 = 2pi/3, A_2 = pi/4.
+ *************************************************************************/
+void albedoproject(double h, double phi, double * coef)
+{
+    double d = R + h;
+    double tmax = asin(R/d);
+
+    double sx = sin(phi);
+    double sz = -cos(phi);
+
+    int i, j, k;
+    for (k=0;k<9;k++)
+        coef[k]=0.0;
+
+    double dt = tmax/ALBEDO_NQ;
+    double dp = 2.0*M_PI/ALBEDO_NQ;
+
+    double w[3], b[9];
+    for (i=0;i<ALBEDO_NQ;i++)
+    {
+        double th = (i + 0.5)*dt;
+        double st = sin(th);
+        double ct = cos(th);
+        for (j=0;j<ALBEDO_NQ;j++)
+        {
+            double ps = (j + 0.5)*dp;
+            double L = capradiance(d, st, ct, sin(ps), cos(ps), sx, sz, w);
+            if (L == 0)
+                continue;
+
+            shbasis(w[0], w[1], w[2], b);
+            for (k=0;k<9;k++)
+                coef[k] += L*b[k]*st*dt*dp;
+        }
+    }
+
+    double A[9] = {M_PI, 2.0*M_PI/3, 2.0*M_PI/3, 2.0*M_PI/3,
+                   M_PI/4, M_PI/4, M_PI/4, M_PI/4, M_PI/4};
+    for (k=0;k<9;k++)
+        coef[k] *= A[k];
+}
+
+/*************************************************************************
+  Прямое интегрирование по шапке - эталон для таблицы.
+ *************************************************************************/
+double albedobrute(double h, double phi, double * n)
+{
+    double d = R + h;
+    double tmax = asin(R/d);
+
+    double sx = sin(phi);
+    double sz = -cos(phi);
+
+    double dt = tmax/ALBEDO_NQ;
+    double dp = 2.0*M_PI/ALBEDO_NQ;
+
+    double E = 0.0;
+    double w[3];
+
+    int i, j;
+    for (i=0;i<ALBEDO_NQ;i++)
+    {
+        double th = (i + 0.5)*dt;
+        double st = sin(th);
+        double ct = cos(th);
+        for (j=0;j<ALBEDO_NQ;j++)
+        {
+            double ps = (j + 0.5)*dp;
+            double L = capradiance(d, st, ct, sin(ps), cos(ps), sx, sz, w);
+            double cn = n[0]*w[0] + n[1]*w[1] + n[2]*w[2];
+            if (cn > 0)
+                E += L*cn*st*dt*dp;
+        }
+    }
+
+    return E;
+}
+
+void albedobuild()
+{
+    albedotable.resize(albedonh*albedonphi*9);
+
+    double coef[9];
+    int i, j, k;
+    for (i=0;i<albedonh;i++)
+    {
+        double h = albedohmin*pow(albedohmax/albedohmin, (double)i/(albedonh - 1));
+        for (j=0;j<albedonphi;j++)
+        {
+            double phi = M_PI*j/(albedonphi - 1);
+            albedoproject(h, phi, coef);
+            for (k=0;k<9;k++)
+                albedotable[(i*albedonphi + j)*9 + k] = coef[k];
+        }
+    }
+}
+
+/*************************************************************************
+  Файл таблицы: nh, nphi (int), hmin, hmax (double), затем
+  nh*nphi*9 чисел float.
+ *************************************************************************/
+int albedosave(const char * name)
+{
+    std::string temp = filetemp(name);
+    std::ofstream out(temp.c_str(), std::ios::binary);
+    if (!out)
+        return 0;
+
+    out.write((const char *)&albedonh, sizeof(int));
+    out.write((const char *)&albedonphi, sizeof(int));
+    out.write((const char *)&albedohmin, sizeof(double));
+    out.write((const char *)&albedohmax, sizeof(double));
+    out.write((const char *)albedotable.data(), albedotable.size()*sizeof(float));
+
+    return filereplace(out, temp, name);
+}
+
+// Параметры сетки меняются, только если файл прочитан целиком: иначе
+// albedobuild строит таблицу на прежней сетке
+int albedoload(const char * name)
+{
+    std::ifstream in(name, std::ios::binary);
+    if (!in)
+        return 0;
+
+    int nh = 0, nphi = 0;
+    double hmin = 0.0, hmax = 0.0;
+    in.read((char *)&nh, sizeof(int));
+    in.read((char *)&nphi, sizeof(int));
+    in.read((char *)&hmin, sizeof(double));
+    in.read((char *)&hmax, sizeof(double));
+    if (!in || nh < 2 || nphi < 2 || nh > ALBEDO_MAXNODES/nphi
+        || !(hmin > 0) || !(hmax > hmin)
+        || (long long)nh*nphi*9*(long long)sizeof(float) != fileremaining(in))
+        return 0;
+
+    std::vector<float> table(nh*nphi*9);
+    in.read((char *)table.data(), table.size()*sizeof(float));
+    if (!in.good())
+        return 0;
+
+    albedonh = nh;
+    albedonphi = nphi;
+    albedohmin = hmin;
+    albedohmax = hmax;
+    albedotable.swap(table);
+    return 1;
+}
+
+/*************************************************************************
+  Таблица нужна только для вывода кадров и замера albedobench: строится
+  при первом обращении - из файла name или заново с записью в него.
+ *************************************************************************/
+void albedoinit(const char * name)
+{
+    if (!albedotable.empty())
+        return;
+
+    if (!albedoload(name))
+    {
+        albedobuild();
+        if (!albedosave(name))
+            std::cerr<<name<<": cannot write"<<std::endl;
+    }
+}
+
+/*************************************************************************
+  Коэффициенты для высоты h и фазового угла phi: билинейная
+  интерполяция по таблице (по логарифму высоты).
+ *************************************************************************/
+void albedosample(double h, double phi, double * coef)
+{
+    // Вне таблицы (в том числе NaN) - отражённого света нет
+    int k;
+    if (albedotable.empty() || !std::isfinite(h) || !std::isfinite(phi) || h <= 0)
+    {
+        for (k=0;k<9;k++)
+            coef[k] = 0.0;
+        return;
+    }
+
+    double u = log(h/albedohmin)/log(albedohmax/albedohmin)*(albedonh - 1);
+    double v = phi/M_PI*(albedonphi - 1);
+
+    u = (u < 0) ? 0 : (u > albedonh - 1.001 ? albedonh - 1.001 : u);
+    v = (v < 0) ? 0 : (v > albedonphi - 1.001 ? albedonphi - 1.001 : v);
+
+    int i = (int)u;
+    int j = (int)v;
+    double fu = u - i;
+    double fv = v - j;
+
+    const float * c00 = &albedotable[(i*albedonphi + j)*9];
+    const float * c01 = c00 + 9;
+    const float * c10 = c00 + albedonphi*9;
+    const float * c11 = c10 + 9;
+
+    for (k=0;k<9;k++)
+    {
+        coef[k] = (1 - fu)*((1 - fv)*c00[k] + fv*c01[k])
+                + fu*((1 - fv)*c10[k] + fv*c11[k]);
+    }
+}
+
+double albedoirradiance(double * coef, double * n)
+{
+    double b[9];
+    shbasis(n[0], n[1], n[2], b);
+
+    double E = 0.0;
+    int k;
+    for (k=0;k<9;k++)
+        E += coef[k]*b[k];
+
+    return (E > 0) ? E : 0.0;
+}
+
+/*************************************************************************
+  Локальная система по векторам на Солнце и на Землю (как их выдают
+  vectosun и vectoearth): высота, фазовый угол и оси X, Z в тех же
+  координатах.
+ *************************************************************************/
+void albedoframe(mtl::dense_vector <double> tosun, mtl::dense_vector <double> toearth,
+                 double * h, double * phi, double * X, double * Z)
+{
+    double dn = two_norm(toearth);
+    double sn = two_norm(tosun);
+
+    *h = dn - R;
+
+    int i;
+    for (i=0;i<3;i++)
+        Z[i] = toearth[i]/dn;
+
+    double cz = 0.0;
+    for (i=0;i<3;i++)
+        cz += tosun[i]/sn*Z[i];
+
+    *phi = acos(-cz > 1 ? 1 : (-cz < -1 ? -1 : -cz));
+
+    double xn = 0.0;
+    for (i=0;i<3;i++)
+    {
+        X[i] = tosun[i]/sn - cz*Z[i];
+        xn += X[i]*X[i];
+    }
+    xn = sqrt(xn);
+
+    // Солнце в зените или надире - X любая перпендикулярная Z
+    if (xn < 1e-9)
+    {
+        double a[3] = {1.0, 0.0, 0.0};
+        if (fabs(Z[0]) > 0.9)
+        {
+            a[0] = 0.0;
+            a[1] = 1.0;
+        }
+        double az = a[0]*Z[0] + a[1]*Z[1] + a[2]*Z[2];
+        xn = 0.0;
+        for (i=0;i<3;i++)
+        {
+            X[i] = a[i] - az*Z[i];
+            xn += X[i]*X[i];
+        }
+        xn = sqrt(xn);
+    }
+
+    for (i=0;i<3;i++)
+        X[i] /= xn;
+}
+
+/*************************************************************************
+  Сравнение таблицы с прямым интегрированием: время на одну оценку и
+  наибольшая ошибка по случайным высотам, фазам и нормалям.
+ *************************************************************************/
+void albedobenchmark()
+{
+    const int count = 200;
+
+    std::vector<double> hs(count), phis(count), ns(3*count);
+
+    srand(1);
+    int i;
+    for (i=0;i<count;i++)
+    {
+        hs[i] = 200000.0*pow(100.0, rand()/(double)RAND_MAX);
+        phis[i] = M_PI*rand()/(double)RAND_MAX;
+
+        double z = 2.0*rand()/(double)RAND_MAX - 1.0;
+        double a = 2.0*M_PI*rand()/(double)RAND_MAX;
+        ns[3*i] = sqrt(1 - z*z)*cos(a);
+        ns[3*i + 1] = sqrt(1 - z*z)*sin(a);
+        ns[3*i + 2] = z;
+    }
+
+    std::vector<double> brute(count), table(count);
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (i=0;i<count;i++)
+        brute[i] = albedobrute(hs[i], phis[i], &ns[3*i]);
+    auto t1 = std::chrono::steady_clock::now();
+
+    double coef[9];
+    const int repeat = 1000;
+    int k;
+    for (k=0;k<repeat;k++)
+    {
+        for (i=0;i<count;i++)
+        {
+            albedosample(hs[i], phis[i], coef);
+            table[i] = albedoirradiance(coef, &ns[3*i]);
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    double err = 0.0;
+    double emax = 0.0;
+    for (i=0;i<count;i++)
+    {
+        if (fabs(table[i] - brute[i]) > err)
+            err = fabs(table[i] - brute[i]);
+        if (brute[i] > emax)
+            emax = brute[i];
+    }
+
+    double nsbrute = std::chrono::duration<double, std::nano>(t1 - t0).count()/count;
+    double nstable = std::chrono::duration<double, std::nano>(t2 - t1).count()/count/repeat;
+
+    std::cout<<"ALBEDO BRUTE "<<nsbrute<<" ns"<<std::endl;
+    std::cout<<"ALBEDO TABLE "<<nstable<<" ns"<<std::endl;
+    std::cout<<"ALBEDO MAX ERROR "<<err<<" OF MAX "<<emax<<std::endl;
+}
@@ -0,0 +1,23 @@
+#ifndef ALBEDO_H
+#define ALBEDO_H
+
+#include <boost/numeric/mtl/mtl.hpp>
+
+// Файл таблицы в текущем каталоге
+#define ALBEDOFILE "albedo.bin"
+
+extern double albedo;
+
+void albedoproject(double h, double phi, double * coef);
+double albedobrute(double h, double phi, double * n);
+void albedobuild();
+int albedosave(const char * name);
+int albedoload(const char * name);
+void albedoinit(const char * name);
+void albedosample(double h, double phi, double * coef);
+double albedoirradiance(double * coef, double * n);
+void albedoframe(mtl::dense_vector <double> tosun, mtl::dense_vector <double> toearth,
+                 double * h, double * phi, double * X, double * Z);
+void albedobenchmark();
+
+#endif // ALBEDO_H
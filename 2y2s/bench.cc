@@ -0,0 +1,267 @@
+#include "detector.h"
+#include "modal.h"
+
+#include <string.h>
+#include <new>
+#include <chrono>
+#include <vector>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define BENCH_CYCLES 1
+#endif
+
+int detectormain(int argc, char** argv);
+
+/*************************************************************************
+  Набор замеров ядер модели: отдельная программа (bench.pro), detector.cc
+  собирается с DETECTOR_NO_MAIN, и main() из него доступен как
+  detectormain. Результаты - в JSON (по умолчанию bench.json), чтобы
+  сравнивать прогоны до и после изменений.
+ *************************************************************************/
+
+// Счётчик выделений памяти: все new (в том числе внутри mtl) идут сюда
+static long allocations = 0;
+
+void * operator new(size_t n)
+{
+    allocations++;
+    void * p = malloc(n ? n : 1);
+    if (!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void * p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void * p, size_t) noexcept
+{
+    free(p);
+}
+
+struct BenchResult
+{
+    std::string name;
+    long ops;
+    double ns;
+    double rhs;
+    double allocs;
+    double cycles;
+};
+
+// Состояние, на котором считаются ядра: начальное состояние main()
+static double by[11+2*MAXMODES];
+static double bresult[6];
+static double bf[11+2*MAXMODES];
+static mtl::dense_vector <double> bd1(3);
+static mtl::dense2D<double> bS(5, 5);
+static mtl::dense_vector <double> bv(5);
+
+// Результаты ядер складываются сюда, чтобы их не выбросил оптимизатор
+static volatile double sink = 0.0;
+
+static void kernelstep()
+{
+    step(11, 0, 0.01, by, 1);
+}
+
+static void kernelff0()
+{
+    ff(0, bresult, bf, 0);
+    sink = sink + bf[3];
+}
+
+static void kernelff1()
+{
+    ff(0, by, bf, 1);
+    sink = sink + bf[0];
+}
+
+static void kernelS()
+{
+    mtl::dense2D<double> A(5, 5);
+    A = S(by);
+    sink = sink + A(0,0);
+}
+
+static void kernelsolve()
+{
+    mtl::dense_vector <double> u(5);
+    u = mtl::mat::inv(bS)*bv;
+    sink = sink + u(0);
+}
+
+static void kernelansi()
+{
+    mtl::dense_vector <double> a(3);
+    a = Ansi(bd1, by);
+    sink = sink + a(0);
+}
+
+static void kernelvectosun()
+{
+    mtl::dense_vector <double> a(3);
+    a = vectosun(by, bresult);
+    sink = sink + a(0);
+}
+
+static void kernelvectoearth()
+{
+    mtl::dense_vector <double> a(3);
+    a = vectoearth(by, bresult);
+    sink = sink + a(0);
+}
+
+static void kernelqmatrix()
+{
+    mtl::dense2D<double> A(3, 3);
+    A = Qmatrix(q(by));
+    sink = sink + A(0,0);
+}
+
+static char benchname[] = "detector";
+
+static void kernelmain()
+{
+    char * argv[2] = {benchname, 0};
+    detectormain(1, argv);
+}
+
+static unsigned long long cycles()
+{
+#ifdef BENCH_CYCLES
+    return __rdtsc();
+#else
+    return 0;
+#endif
+}
+
+/*************************************************************************
+  Замер одного ядра: число повторов удваивается, пока серия не займёт
+  mintime секунд, результат - последняя серия.
+ *************************************************************************/
+static BenchResult measure(const char * name, void (*kernel)(), double mintime, long maxops)
+{
+    BenchResult r;
+    r.name = name;
+
+    long ops = 1;
+    for (;;)
+    {
+        long calls0 = rhscalls;
+        long allocs0 = allocations;
+        unsigned long long c0 = cycles();
+        auto t0 = std::chrono::steady_clock::now();
+
+        long i;
+        for (i=0;i<ops;i++)
+            kernel();
+
+        auto t1 = std::chrono::steady_clock::now();
+        unsigned long long c1 = cycles();
+        double seconds = std::chrono::duration<double>(t1 - t0).count();
+
+        if (seconds >= mintime || ops >= maxops)
+        {
+            r.ops = ops;
+            r.ns = seconds*1e9/ops;
+            r.rhs = (rhscalls - calls0)/seconds;
+            r.allocs = (double)(allocations - allocs0)/ops;
+            r.cycles = (double)(c1 - c0)/ops;
+            break;
+        }
+        ops *= 2;
+    }
+
+    std::cerr<<r.name<<" "<<r.ns<<" ns/op"<<std::endl;
+    return r;
+}
+
+int main(int argc, char** argv)
+{
+    using namespace mtl;
+
+    const char * output = "bench.json";
+    double mintime = 0.2;
+
+    int arg;
+    for (arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "-o") == 0 && arg + 1 < argc)
+            output = argv[++arg];
+        else if (strcmp(argv[arg], "-time") == 0 && arg + 1 < argc)
+            mintime = atof(argv[++arg]);
+    }
+
+    std::vector<BenchResult> results;
+
+    // Полный прогон 150 кадров заодно задаёт I1, I2, a1, a2_, e1, c
+    results.push_back(measure("main_150_frames", kernelmain, mintime, 3));
+
+    int i;
+    for (i=0;i<11+2*MAXMODES;i++)
+        by[i]=0.0;
+    by[0]=0.001;
+    by[1]=0.001;
+    by[2]=0.001;
+    by[3]=1.0;
+    by[9]=0.001;
+    by[10]=0.001;
+
+    bresult[0]=0;
+    bresult[1]=6500000;
+    bresult[2]=0;
+    bresult[3]=sqrt(M/6500000);
+    bresult[4]=0;
+    bresult[5]=0;
+
+    sunvec[0]=0;
+    sunvec[1]=150000000000;
+    sunvec[2]=0;
+
+    bd1(0)=-0.5;
+    bd1(1)=1.0;
+    bd1(2)=0.01;
+
+    bS=S(by);
+    bv=v(by);
+
+    results.push_back(measure("step_flag1", kernelstep, mintime, 1L<<30));
+    results.push_back(measure("ff_flag0", kernelff0, mintime, 1L<<30));
+    results.push_back(measure("ff_flag1", kernelff1, mintime, 1L<<30));
+    results.push_back(measure("S_build", kernelS, mintime, 1L<<30));
+    results.push_back(measure("S_solve", kernelsolve, mintime, 1L<<30));
+    results.push_back(measure("Ansi", kernelansi, mintime, 1L<<30));
+    results.push_back(measure("vectosun", kernelvectosun, mintime, 1L<<30));
+    results.push_back(measure("vectoearth", kernelvectoearth, mintime, 1L<<30));
+    results.push_back(measure("Qmatrix", kernelqmatrix, mintime, 1L<<30));
+
+    std::ofstream json(output);
+    json<<"{"<<std::endl;
+    json<<"  \"benchmarks\": ["<<std::endl;
+    size_t k;
+    for (k=0;k<results.size();k++)
+    {
+        BenchResult & r = results[k];
+        json<<"    {\"name\": \""<<r.name<<"\", \"ops\": "<<r.ops
+            <<", \"ns_per_op\": "<<r.ns
+            <<", \"rhs_per_s\": "<<r.rhs
+            <<", \"allocs_per_op\": "<<r.allocs
+            <<", \"cycles_per_op\": ";
+#ifdef BENCH_CYCLES
+        json<<r.cycles;
+#else
+        json<<"null";
+#endif
+        json<<"}"<<((k + 1 < results.size()) ? "," : "")<<std::endl;
+    }
+    json<<"  ]"<<std::endl;
+    json<<"}"<<std::endl;
+    json.close();
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+TEMPLATE = app
+CONFIG += console c++11 thread
+CONFIG -= app_bundle
+CONFIG -= qt
+
+QMAKE_CXXFLAGS += -fopenmp-simd -fno-math-errno -fno-trapping-math
+QMAKE_CXXFLAGS_RELEASE -= -O2
+QMAKE_CXXFLAGS_RELEASE += -O3
+
+# Трассировка по зонам (trace.h): detector_trace.json в конце прогона
+#DEFINES += ENABLE_TRACE
+
+# Программа замеров: та же модель, main() - из bench.cc
+DEFINES += DETECTOR_NO_MAIN
+TARGET = bench
+
+SOURCES += \
+    bench.cc \
+    detector.cc \
+    parareal.cc \
+    linear.cc \
+    adaptive.cc \
+    chain.cc \
+    hingestop.cc \
+    eclipse.cc \
+    albedo.cc \
+    chebyshev.cc \
+    sun.cc \
+    ephemeris.cc \
+    geopotential.cc \
+    srp.cc \
+    adcs.cc \
+    modal.cc \
+    reference.cc \
+    conservation.cc \
+    golden.cc \
+    scenario.cc \
+    runcache.cc \
+    checkpoint.cc \
+    binfile.cc \
+    sweep.cc \
+    ensemble.cc \
+    trace.cc
+
+HEADERS += \
+    detector.h \
+    parareal.h \
+    linear.h \
+    adaptive.h \
+    chain.h \
+    hingestop.h \
+    eclipse.h \
+    albedo.h \
+    chebyshev.h \
+    sun.h \
+    ephemeris.h \
+    geopotential.h \
+    srp.h \
+    adcs.h \
+    modal.h \
+    reference.h \
+    conservation.h \
+    golden.h \
+    scenario.h \
+    runcache.h \
+    checkpoint.h \
+    binfile.h \
+    sweep.h \
+    ensemble.h \
+    trace.h
@@ -0,0 +1,86 @@
+#include "binfile.h"
+
+#include <stdio.h>
+
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <process.h>
+#include <io.h>
+#include <direct.h>
+#include <fcntl.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+std::string filetemp(const std::string & name)
+{
+    char suffix[32];
+    snprintf(suffix, sizeof(suffix), ".%d.tmp", (int)getpid());
+    return name + suffix;
+}
+
+/*************************************************************************
+  rename() в Windows не заменяет существующий файл - там замена через
+  MoveFileEx с MOVEFILE_REPLACE_EXISTING.
+ *************************************************************************/
+int filereplace(std::ofstream & out, const std::string & temp, const std::string & name)
+{
+    out.close();
+    int ok = out.good();
+
+#ifdef _WIN32
+    if (ok)
+        ok = MoveFileExA(temp.c_str(), name.c_str(),
+                         MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    if (ok)
+        ok = rename(temp.c_str(), name.c_str()) == 0;
+#endif
+
+    if (!ok)
+        remove(temp.c_str());
+    return ok;
+}
+
+long long fileremaining(std::ifstream & in)
+{
+    std::streampos here = in.tellg();
+    if (here < 0)
+        return 0;
+    in.seekg(0, std::ios::end);
+    std::streampos end = in.tellg();
+    in.seekg(here);
+    if (end < here)
+        return 0;
+    return (long long)(end - here);
+}
+
+int truncatefile(const char * name, long size)
+{
+#ifdef _WIN32
+    int fd = _open(name, _O_RDWR | _O_BINARY);
+    if (fd < 0)
+        return 0;
+    int ok = _chsize(fd, size) == 0;
+    _close(fd);
+    return ok;
+#else
+    return truncate(name, (off_t)size) == 0;
+#endif
+}
+
+int makedirectory(const char * name)
+{
+    struct stat st;
+    if (stat(name, &st) == 0)
+        return S_ISDIR(st.st_mode) ? 1 : 0;
+
+#ifdef _WIN32
+    return _mkdir(name) == 0;
+#else
+    return mkdir(name, 0777) == 0;
+#endif
+}
@@ -0,0 +1,27 @@
+#ifndef BINFILE_H
+#define BINFILE_H
+
+#include <string>
+#include <fstream>
+
+/*************************************************************************
+  Двоичные файлы прогонов (кэш, контрольные точки, эталоны, части
+  перебора, статистика, таблица альбедо) пишутся во временный файл
+  процесса filetemp(name) и заменяют name в filereplace: прерывание
+  записи или параллельный процесс с тем же файлом не оставляют его
+  недописанным. filereplace закрывает out, при ошибке удаляет
+  временный файл и возвращает 0.
+
+  fileremaining - сколько байт осталось до конца файла: поля размеров
+  при чтении сверяются с ним до выделения памяти. truncatefile
+  обрезает файл до size байт (файлы вывода при продолжении прогона).
+  makedirectory создаёт каталог name, если его нет (кэш прогонов), и
+  возвращает 0, если каталога так и нет.
+ *************************************************************************/
+std::string filetemp(const std::string & name);
+int filereplace(std::ofstream & out, const std::string & temp, const std::string & name);
+long long fileremaining(std::ifstream & in);
+int truncatefile(const char * name, long size);
+int makedirectory(const char * name);
+
+#endif // BINFILE_H
@@ -0,0 +1,294 @@
+#include "detector.h"
+#include "chain.h"
+
+std::vector<Body> bodies;
+
+/*************************************************************************
+  Пространственная алгебра (Featherstone, "Rigid Body Dynamics
+  Algorithms"). Векторы движения - [omega; v], силы - [n; f], всё в
+  системе координат тела, с началом в точке его шарнира.
+ *************************************************************************/
+static mtl::dense2D<double> skew(mtl::dense_vector <double> a)
+{
+    mtl::dense2D<double> A(3, 3);
+    A = 0.0;
+    A(0,1)=-a[2];
+    A(0,2)= a[1];
+    A(1,0)= a[2];
+    A(1,2)=-a[0];
+    A(2,0)=-a[1];
+    A(2,1)= a[0];
+    return A;
+}
+
+// Поворот на угол t вокруг единичной оси a (формула Родрига)
+static mtl::dense2D<double> rotation(mtl::dense_vector <double> a, double t)
+{
+    using namespace mtl;
+    dense2D<double> A(3, 3);
+    A = 1.0;
+
+    dense2D<double> W(3, 3);
+    W = skew(a);
+
+    A += dense2D<double>(W * sin(t)) + dense2D<double>(dense2D<double>(W * W) * (1.0 - cos(t)));
+    return A;
+}
+
+// Преобразование векторов движения из системы родителя в систему тела:
+// E - поворот координат, p - начало системы тела в системе родителя
+static mtl::dense2D<double> Xform(mtl::dense2D<double> E, mtl::dense_vector <double> p)
+{
+    using namespace mtl;
+    dense2D<double> X(6, 6);
+    X = 0.0;
+
+    dense2D<double> B(3, 3);
+    B = E * skew(p);
+
+    int i, j;
+    for (i=0;i<3;i++)
+    {
+        for (j=0;j<3;j++)
+        {
+            X(i,j)=E(i,j);
+            X(i+3,j+3)=E(i,j);
+            X(i+3,j)=-B(i,j);
+        }
+    }
+    return X;
+}
+
+// Матрица векторного произведения векторов движения v x
+static mtl::dense2D<double> crm(mtl::dense_vector <double> v)
+{
+    using namespace mtl;
+    dense2D<double> X(6, 6);
+    X = 0.0;
+
+    dense_vector <double> w(3), u(3);
+    int i, j;
+    for (i=0;i<3;i++)
+    {
+        w(i)=v(i);
+        u(i)=v(i+3);
+    }
+
+    dense2D<double> W(3, 3);
+    W = skew(w);
+    dense2D<double> U(3, 3);
+    U = skew(u);
+
+    for (i=0;i<3;i++)
+    {
+        for (j=0;j<3;j++)
+        {
+            X(i,j)=W(i,j);
+            X(i+3,j+3)=W(i,j);
+            X(i+3,j)=U(i,j);
+        }
+    }
+    return X;
+}
+
+// Пространственный тензор инерции относительно начала системы тела
+static mtl::dense2D<double> inertia(double m, mtl::dense_vector <double> cm, mtl::dense2D<double> Ic)
+{
+    using namespace mtl;
+    dense2D<double> X(6, 6);
+    X = 0.0;
+
+    dense2D<double> C(3, 3);
+    C = skew(cm);
+
+    dense2D<double> A(3, 3);
+    A = Ic + dense2D<double>(dense2D<double>(C * trans(C)) * m);
+
+    int i, j;
+    for (i=0;i<3;i++)
+    {
+        for (j=0;j<3;j++)
+        {
+            X(i,j)=A(i,j);
+            X(i,j+3)=m*C(i,j);
+            X(i+3,j)=m*C(j,i);
+        }
+        X(i+3,i+3)=m;
+    }
+    return X;
+}
+
+/*************************************************************************
+  Построение дерева тел.
+ *************************************************************************/
+int chaindof()
+{
+    return bodies.size() - 1;
+}
+
+void chainbase(mtl::dense2D <double> Ib)
+{
+    Body b;
+    b.parent = -1;
+    b.r = mtl::dense_vector <double>(3, 0.0);
+    b.axis = mtl::dense_vector <double>(3, 0.0);
+    b.mass = 0.0;
+    b.com = mtl::dense_vector <double>(3, 0.0);
+    b.I = Ib;
+
+    bodies.clear();
+    bodies.push_back(b);
+}
+
+int chainhinge1(int parent, mtl::dense_vector <double> r, mtl::dense_vector <double> axis,
+                double mass, mtl::dense_vector <double> com, mtl::dense2D <double> I)
+{
+    Body b;
+    b.parent = parent;
+    b.r = r;
+    b.axis = axis;
+    b.mass = mass;
+    b.com = com;
+    b.I = I;
+
+    bodies.push_back(b);
+    return bodies.size() - 1;
+}
+
+int chainhinge2(int parent, mtl::dense_vector <double> r, mtl::dense_vector <double> axis1,
+                mtl::dense_vector <double> axis2, double mass, mtl::dense_vector <double> com,
+                mtl::dense2D <double> I)
+{
+    mtl::dense2D <double> I0(3, 3);
+    I0 = 0.0;
+
+    int k = chainhinge1(parent, r, axis1, 0.0, mtl::dense_vector <double>(3, 0.0), I0);
+    return chainhinge1(k, mtl::dense_vector <double>(3, 0.0), axis2, mass, com, I);
+}
+
+/*************************************************************************
+  Текущая модель как частный случай: спутник с тензором I1 и одна
+  панель единичной массы на двухстепенном шарнире в точке a1. Первый
+  поворот - вокруг e1 (оси y спутника, угол y[7]), второй - вокруг
+  повёрнутой оси x (угол y[8]), как в матрицах B1 и B3.
+ *************************************************************************/
+void chainfrompanel()
+{
+    mtl::dense_vector <double> ex(3, 0.0);
+    ex(0) = 1.0;
+
+    chainbase(I1);
+    chainhinge2(0, a1, e1, ex, 1.0, a2_, I2);
+}
+
+/*************************************************************************
+  Правая часть для дерева тел (flag=3): алгоритм шарнирных тел
+  Featherstone, число операций линейно по числу тел.
+
+  y[0..2] - угловая скорость спутника, y[3..6] - кватернион,
+  y[7..7+n-1] - углы шарниров, y[7+n..7+2n-1] - их скорости, n=chaindof().
+  Для chainfrompanel раскладка совпадает с flag=1.
+ *************************************************************************/
+void ffchain(double x, double * y, double * f)
+{
+    using namespace mtl;
+
+    int N = bodies.size();
+    int n = N - 1;
+
+    std::vector< dense2D<double> > X(N), IA(N);
+    std::vector< dense_vector<double> > vel(N), cc(N), pA(N), S(N), U(N), a(N);
+    std::vector<double> D(N), u(N), qdd(N);
+
+    int i, k;
+
+    // Скорости и скоростные слагаемые ускорений, от корня к листьям
+    vel[0] = dense_vector <double>(6, 0.0);
+    for (k=0;k<3;k++)
+        vel[0](k)=y[k];
+    cc[0] = dense_vector <double>(6, 0.0);
+    IA[0] = inertia(bodies[0].mass, bodies[0].com, bodies[0].I);
+    pA[0] = -dense_vector <double>(trans(crm(vel[0])) * dense_vector <double>(IA[0] * vel[0]));
+
+    for (i=1;i<N;i++)
+    {
+        double qi = y[6+i];
+        double qdi = y[6+n+i];
+
+        X[i] = Xform(trans(rotation(bodies[i].axis, qi)), bodies[i].r);
+
+        S[i] = dense_vector <double>(6, 0.0);
+        for (k=0;k<3;k++)
+            S[i](k)=bodies[i].axis(k);
+
+        vel[i] = dense_vector <double>(X[i] * vel[bodies[i].parent]) + S[i] * qdi;
+        cc[i] = crm(vel[i]) * dense_vector <double>(S[i] * qdi);
+
+        IA[i] = inertia(bodies[i].mass, bodies[i].com, bodies[i].I);
+        pA[i] = -dense_vector <double>(trans(crm(vel[i])) * dense_vector <double>(IA[i] * vel[i]));
+    }
+
+    // Шарнирные инерции, от листьев к корню
+    for (i=N-1;i>0;i--)
+    {
+        U[i] = IA[i] * S[i];
+        D[i] = dot(S[i], U[i]);
+        u[i] = - dot(S[i], pA[i]);
+
+        dense2D<double> Ia(6, 6);
+        Ia = IA[i];
+        int j;
+        for (k=0;k<6;k++)
+        {
+            for (j=0;j<6;j++)
+                Ia(k,j) -= U[i](k)*U[i](j)/D[i];
+        }
+
+        dense_vector <double> pa(6);
+        pa = pA[i] + dense_vector <double>(Ia * cc[i]) + U[i] * (u[i]/D[i]);
+
+        int p = bodies[i].parent;
+        IA[p] += dense2D<double>(dense2D<double>(trans(X[i]) * Ia) * X[i]);
+        pA[p] += dense_vector <double>(trans(X[i]) * pa);
+    }
+
+    // Сферический шарнир спутника вокруг неподвижной точки
+    dense2D<double> D0(3, 3);
+    dense_vector <double> u0(3);
+    int j;
+    for (k=0;k<3;k++)
+    {
+        for (j=0;j<3;j++)
+            D0(k,j)=IA[0](k,j);
+        u0(k)=-pA[0](k);
+    }
+
+    dense_vector <double> dw(3);
+    dw = mat::inv(D0) * u0;
+
+    a[0] = dense_vector <double>(6, 0.0);
+    for (k=0;k<3;k++)
+        a[0](k)=dw(k);
+
+    // Ускорения, от корня к листьям
+    for (i=1;i<N;i++)
+    {
+        a[i] = dense_vector <double>(X[i] * a[bodies[i].parent]) + cc[i];
+        qdd[i] = (u[i] - dot(U[i], a[i]))/D[i];
+        a[i] += S[i] * qdd[i];
+    }
+
+    for (k=0;k<3;k++)
+        f[k]=dw(k);
+
+    dense_vector <double> dq4(4);
+    dq4 = dq(y);
+    for (k=3;k<7;k++)
+        f[k]=dq4(k-3);
+
+    for (i=1;i<N;i++)
+    {
+        f[6+i]=y[6+n+i];
+        f[6+n+i]=qdd[i];
+    }
+}
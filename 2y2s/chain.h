@@ -0,0 +1,36 @@
+#ifndef CHAIN_H
+#define CHAIN_H
+
+#include <vector>
+
+#include <boost/numeric/mtl/mtl.hpp>
+
+/*************************************************************************
+  Тело дерева. Тело 0 - спутник, вращающийся вокруг неподвижной точки O
+  (кватернион и угловая скорость в y[0..6]). Остальные тела крепятся к
+  родителю вращательным шарниром с одной степенью свободы; шарнир с
+  двумя степенями - это два шарнира подряд с невесомым телом между ними.
+ *************************************************************************/
+struct Body
+{
+    int parent;
+    mtl::dense_vector <double> r;      // точка шарнира в системе родителя
+    mtl::dense_vector <double> axis;   // ось шарнира (единичная)
+    double mass;
+    mtl::dense_vector <double> com;    // центр масс в системе тела
+    mtl::dense2D <double> I;           // центральный тензор инерции
+};
+
+extern std::vector<Body> bodies;
+
+int chaindof();
+void chainbase(mtl::dense2D <double> Ib);
+int chainhinge1(int parent, mtl::dense_vector <double> r, mtl::dense_vector <double> axis,
+                double mass, mtl::dense_vector <double> com, mtl::dense2D <double> I);
+int chainhinge2(int parent, mtl::dense_vector <double> r, mtl::dense_vector <double> axis1,
+                mtl::dense_vector <double> axis2, double mass, mtl::dense_vector <double> com,
+                mtl::dense2D <double> I);
+void chainfrompanel();
+void ffchain(double x, double * y, double * f);
+
+#endif // CHAIN_H
@@ -0,0 +1,185 @@
+#include "detector.h"
+#include "chebyshev.h"
+#include "binfile.h"
+
+/*************************************************************************
+  Коэффициенты сегмента seg по значениям функции в узлах Чебышёва
+  x_i = cos(pi*(i+0.5)/ncoef), i=0..ncoef-1 (values[i*dim + k]):
+
+      c_j = 2/ncoef * sum_i f(x_i) cos(pi*j*(i+0.5)/ncoef),
+
+  c_0 берётся с половинным весом при вычислении.
+ *************************************************************************/
+void chebfitsegment(Chebyshev & ch, int seg, const double * values)
+{
+    int n = ch.ncoef;
+
+    int i, j, k;
+    for (k=0;k<ch.dim;k++)
+    {
+        double * c = &ch.c[(seg*ch.dim + k)*n];
+        for (j=0;j<n;j++)
+        {
+            double s = 0.0;
+            for (i=0;i<n;i++)
+                s += values[i*ch.dim + k]*cos(M_PI*j*(i + 0.5)/n);
+            c[j] = 2.0*s/n;
+        }
+        c[0] *= 0.5;
+    }
+}
+
+/*************************************************************************
+  Аппроксимация функции f на [t0, t1] сегментами длины len. Ошибка
+  проверяется в серединах между узлами каждого сегмента.
+ *************************************************************************/
+void chebfit(Chebyshev & ch, double t0, double t1, double len, int ncoef, int dim,
+             chebfunction f, void * data)
+{
+    ch.dim = dim;
+    ch.ncoef = ncoef;
+    ch.t0 = t0;
+    ch.len = len;
+    ch.segments = (int)ceil((t1 - t0)/len);
+    if (ch.segments < 1)
+        ch.segments = 1;
+    ch.error = 0.0;
+    ch.c.assign(ch.segments*dim*ncoef, 0.0);
+
+    std::vector<double> values(ncoef*dim);
+    std::vector<double> exact(dim), approx(dim);
+
+    int s, i, k;
+    for (s=0;s<ch.segments;s++)
+    {
+        double a = t0 + s*len;
+        for (i=0;i<ncoef;i++)
+        {
+            double x = cos(M_PI*(i + 0.5)/ncoef);
+            f(a + 0.5*len*(x + 1.0), &values[i*dim], data);
+        }
+        chebfitsegment(ch, s, values.data());
+
+        for (i=0;i<ncoef;i++)
+        {
+            double x = cos(M_PI*(i + 1.0)/ncoef);
+            double t = a + 0.5*len*(x + 1.0);
+            f(t, exact.data(), data);
+            chebeval(ch, t, approx.data());
+            for (k=0;k<dim;k++)
+            {
+                if (fabs(exact[k] - approx[k]) > ch.error)
+                    ch.error = fabs(exact[k] - approx[k]);
+            }
+        }
+    }
+}
+
+static int chebsegment(const Chebyshev & ch, double t, double * x)
+{
+    int s = (int)floor((t - ch.t0)/ch.len);
+    if (s < 0)
+        s = 0;
+    if (s > ch.segments - 1)
+        s = ch.segments - 1;
+
+    *x = 2.0*(t - ch.t0 - s*ch.len)/ch.len - 1.0;
+    return s;
+}
+
+/*************************************************************************
+  Значение в момент t по схеме Кленшоу: ncoef умножений-сложений на
+  координату.
+ *************************************************************************/
+void chebeval(const Chebyshev & ch, double t, double * out)
+{
+    double x;
+    int s = chebsegment(ch, t, &x);
+
+    int j, k;
+    for (k=0;k<ch.dim;k++)
+    {
+        const double * c = &ch.c[(s*ch.dim + k)*ch.ncoef];
+        double b1 = 0.0;
+        double b2 = 0.0;
+        for (j=ch.ncoef-1;j>0;j--)
+        {
+            double b = 2.0*x*b1 - b2 + c[j];
+            b2 = b1;
+            b1 = b;
+        }
+        out[k] = x*b1 - b2 + c[0];
+    }
+}
+
+/*************************************************************************
+  Производная по t: T_j'(x) = j U_{j-1}(x), U - многочлены второго рода,
+  сумма тоже по схеме Кленшоу.
+ *************************************************************************/
+void chebderiv(const Chebyshev & ch, double t, double * out)
+{
+    double x;
+    int s = chebsegment(ch, t, &x);
+
+    int j, k;
+    for (k=0;k<ch.dim;k++)
+    {
+        const double * c = &ch.c[(s*ch.dim + k)*ch.ncoef];
+        double b1 = 0.0;
+        double b2 = 0.0;
+        for (j=ch.ncoef-1;j>0;j--)
+        {
+            double b = 2.0*x*b1 - b2 + j*c[j];
+            b2 = b1;
+            b1 = b;
+        }
+        // sum j c_j U_{j-1}(x) = b1 (U_0 = 1)
+        out[k] = b1*2.0/ch.len;
+    }
+}
+
+/*************************************************************************
+  Запись и чтение аппроксимации: размеры, отрезок, ошибка и
+  коэффициенты подряд в двоичном виде. Запись - через filetemp и
+  filereplace, при чтении число коэффициентов сверяется с длиной файла.
+ *************************************************************************/
+int chebsave(const Chebyshev & ch, const char * name)
+{
+    std::string temp = filetemp(name);
+
+    std::ofstream out(temp.c_str(), std::ios::binary);
+    if (!out)
+        return 0;
+
+    out.write((const char *)&ch.dim, sizeof(int));
+    out.write((const char *)&ch.ncoef, sizeof(int));
+    out.write((const char *)&ch.segments, sizeof(int));
+    out.write((const char *)&ch.t0, sizeof(double));
+    out.write((const char *)&ch.len, sizeof(double));
+    out.write((const char *)&ch.error, sizeof(double));
+    out.write((const char *)ch.c.data(), ch.c.size()*sizeof(double));
+
+    return filereplace(out, temp, name);
+}
+
+int chebload(Chebyshev & ch, const char * name)
+{
+    std::ifstream in(name, std::ios::binary);
+    if (!in)
+        return 0;
+
+    in.read((char *)&ch.dim, sizeof(int));
+    in.read((char *)&ch.ncoef, sizeof(int));
+    in.read((char *)&ch.segments, sizeof(int));
+    in.read((char *)&ch.t0, sizeof(double));
+    in.read((char *)&ch.len, sizeof(double));
+    in.read((char *)&ch.error, sizeof(double));
+    if (!in || ch.dim < 1 || ch.ncoef < 1 || ch.segments < 1 || !(ch.len > 0)
+        || (long long)ch.segments*ch.dim*ch.ncoef*(long long)sizeof(double) != fileremaining(in))
+        return 0;
+
+    ch.c.resize((size_t)ch.segments*ch.dim*ch.ncoef);
+    in.read((char *)ch.c.data(), ch.c.size()*sizeof(double));
+
+    return in.good() ? 1 : 0;
+}
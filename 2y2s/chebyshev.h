@@ -0,0 +1,33 @@
+#ifndef CHEBYSHEV_H
+#define CHEBYSHEV_H
+
+#include <vector>
+
+/*************************************************************************
+  Кусочно-чебышёвская аппроксимация вектор-функции времени: отрезок
+  [t0, t0+segments*len] разбит на равные сегменты, на каждом по ncoef
+  коэффициентов на каждую из dim координат. Сегмент по времени
+  находится делением, так что запрос стоит O(1).
+ *************************************************************************/
+struct Chebyshev
+{
+    int dim;
+    int ncoef;
+    int segments;
+    double t0;
+    double len;
+    double error;               // наибольшая ошибка на проверочных точках
+    std::vector<double> c;      // c[(seg*dim + k)*ncoef + j]
+};
+
+typedef void (*chebfunction)(double t, double * out, void * data);
+
+void chebfit(Chebyshev & ch, double t0, double t1, double len, int ncoef, int dim,
+             chebfunction f, void * data);
+void chebfitsegment(Chebyshev & ch, int seg, const double * values);
+void chebeval(const Chebyshev & ch, double t, double * out);
+void chebderiv(const Chebyshev & ch, double t, double * out);
+int chebsave(const Chebyshev & ch, const char * name);
+int chebload(Chebyshev & ch, const char * name);
+
+#endif // CHEBYSHEV_H
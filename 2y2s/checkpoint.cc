@@ -0,0 +1,121 @@
+#include "detector.h"
+#include "checkpoint.h"
+#include "adaptive.h"
+#include "adcs.h"
+#include "conservation.h"
+#include "hingestop.h"
+#include "binfile.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Признак файла контрольной точки ("CKP1")
+#define CHECKPOINTMAGIC 0x31504b43
+
+void ckio(Checkpoint & ck, double * v, int n)
+{
+    int i;
+    if (!ck.restore)
+    {
+        for (i=0;i<n;i++)
+            ck.data.push_back(v[i]);
+        return;
+    }
+
+    if (ck.failed || ck.pos + n > ck.data.size())
+    {
+        ck.failed = 1;
+        return;
+    }
+    for (i=0;i<n;i++)
+        v[i] = ck.data[ck.pos++];
+}
+
+void ckio(Checkpoint & ck, int & v)
+{
+    double d = v;
+    ckio(ck, &d, 1);
+    v = (int)d;
+}
+
+void ckio(Checkpoint & ck, long & v)
+{
+    double d = (double)v;
+    ckio(ck, &d, 1);
+    v = (long)d;
+}
+
+/*************************************************************************
+  Глобальное состояние модулей, которое меняется по ходу прогона:
+  счётчик правой части, модель с переключением, упоры, ADCS и проверка
+  законов сохранения. Остальное (таблицы, поле Земли, эфемериды)
+  строится заново тем же кодом и совпадает побитно.
+ *************************************************************************/
+void checkpointmodules(Checkpoint & ck)
+{
+    long calls = rhscalls;
+    ckio(ck, calls);
+    rhscalls = calls;
+    adaptivecheckpoint(ck);
+    ckio(ck, impacts);
+    ckio(ck, contacts);
+    adcscheckpoint(ck);
+    monitorcheckpoint(ck);
+}
+
+/*************************************************************************
+  Файл: признак, ключ прогона (сверяется при чтении, чтобы не продолжить
+  другой сценарий), число чисел и сами числа. Запись через filetemp и
+  filereplace: прерывание во время записи оставляет предыдущую точку
+  целой.
+ *************************************************************************/
+int checkpointsave(const std::string & name, const std::vector<double> & key, const Checkpoint & ck)
+{
+    std::string temp = filetemp(name);
+    std::ofstream out(temp.c_str(), std::ios::binary);
+    if (!out)
+        return 0;
+
+    int magic = CHECKPOINTMAGIC;
+    int keysize = (int)key.size();
+    long size = (long)ck.data.size();
+    out.write((const char *)&magic, sizeof(int));
+    out.write((const char *)&keysize, sizeof(int));
+    out.write((const char *)key.data(), keysize*sizeof(double));
+    out.write((const char *)&size, sizeof(long));
+    out.write((const char *)ck.data.data(), size*sizeof(double));
+
+    return filereplace(out, temp, name);
+}
+
+int checkpointload(const std::string & name, const std::vector<double> & key, Checkpoint & ck)
+{
+    std::ifstream in(name.c_str(), std::ios::binary);
+    if (!in)
+        return 0;
+
+    int magic = 0, keysize = 0;
+    in.read((char *)&magic, sizeof(int));
+    in.read((char *)&keysize, sizeof(int));
+    if (!in || magic != CHECKPOINTMAGIC || keysize != (int)key.size()
+        || (long long)keysize*(long long)sizeof(double) > fileremaining(in))
+        return 0;
+
+    std::vector<double> filekey(keysize);
+    in.read((char *)filekey.data(), keysize*sizeof(double));
+    if (!in || memcmp(filekey.data(), key.data(), keysize*sizeof(double)) != 0)
+        return 0;
+
+    long size = 0;
+    in.read((char *)&size, sizeof(long));
+    if (!in || size < 1 || (long long)size*(long long)sizeof(double) != fileremaining(in))
+        return 0;
+
+    ck.data.resize(size);
+    in.read((char *)ck.data.data(), size*sizeof(double));
+    ck.restore = 1;
+    ck.failed = 0;
+    ck.pos = 0;
+
+    return in.good() ? 1 : 0;
+}
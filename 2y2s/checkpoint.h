@@ -0,0 +1,29 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <vector>
+#include <string>
+
+/*************************************************************************
+  Контрольная точка прогона - последовательность чисел double. Запись и
+  чтение идут одними и теми же вызовами ckio в одном порядке: при
+  restore = 0 значения дописываются в data, при restore = 1 читаются
+  из data с позиции pos. Целые хранятся в double точно (до 2^53).
+ *************************************************************************/
+struct Checkpoint
+{
+    int restore;
+    int failed;
+    size_t pos;
+    std::vector<double> data;
+};
+
+void ckio(Checkpoint & ck, double * v, int n);
+void ckio(Checkpoint & ck, int & v);
+void ckio(Checkpoint & ck, long & v);
+
+void checkpointmodules(Checkpoint & ck);
+int checkpointsave(const std::string & name, const std::vector<double> & key, const Checkpoint & ck);
+int checkpointload(const std::string & name, const std::vector<double> & key, Checkpoint & ck);
+
+#endif // CHECKPOINT_H
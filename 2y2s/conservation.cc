@@ -0,0 +1,149 @@
+#include "detector.h"
+#include "conservation.h"
+#include "checkpoint.h"
+#include "reference.h"
+
+// Проверка законов сохранения в модели с панелью на шарнире и с
+// застопоренной панелью: включена ли и через сколько шагов
+int monitor = 0;
+
+int monitorevery = 10;
+
+// Проверка по состояниям на концах кадров (monitorframe) вместо шагов:
+// Parareal проходит шаги в потоках и по нескольку раз за итерации,
+// линейная модель переходит через кадр скачком
+int monitorframes = 0;
+
+// Наибольший уход кинетического момента (относительный, по модулю
+// разности векторов) и энергии (относительный) с начала прогона
+double momentumdrift = 0.0;
+
+double energydrift = 0.0;
+
+// Файл с рядом: номер шага, |H|, T и уходы от начальных значений
+std::ofstream monitorfile;
+
+// Начальные значения и счётчик шагов
+static double monitorH[3];
+static double monitorT = 0.0;
+static long monitorsteps = 0;
+
+/*************************************************************************
+  Кинетический момент системы в инерциальной системе H и кинетическая
+  энергия T по состоянию y. Панель единичной массы, её центр масс
+  a1 + alpha2 движется со скоростью u = omega x a1 + w2 x alpha2:
+
+      H = I1 omega + J2 w2 + (a1 + alpha2) x u,
+      T = (omega.I1 omega + w2.J2 w2 + |u|^2)/2,
+
+  то же, что верхние строки S(y) на (omega, psi1', psi2'). В связанную
+  систему H переводится по кватерниону в соглашении кинематики dq.
+ *************************************************************************/
+void conservation(double * y, double * H, double * T)
+{
+    using namespace mtl;
+
+    dense_vector <double> w(3);
+    w=omega1(y);
+
+    dense_vector <double> w2v(3);
+    w2v=w2(y);
+
+    dense_vector <double> al(3);
+    al=alpha2(y);
+
+    dense_vector <double> u(3);
+    u=cross(w, a1) + cross(w2v, al);
+
+    dense_vector <double> I1w(3);
+    I1w=I1*w;
+
+    dense_vector <double> J2w(3);
+    J2w=J2(y)*w2v;
+
+    dense_vector <double> hb(3);
+    hb=I1w + J2w + cross(dense_vector <double>(a1 + al), u);
+
+    *T=0.5*(dot(w, I1w) + dot(w2v, J2w) + dot(u, u));
+
+    double A[3][3];
+    quaterniontomatrix(y + 3, A);
+
+    int i, k;
+    for (i=0;i<3;i++)
+    {
+        H[i]=0.0;
+        for (k=0;k<3;k++)
+            H[i]+=A[k][i]*hb(k);
+    }
+}
+
+void monitorreset(double * y)
+{
+    conservation(y, monitorH, &monitorT);
+    momentumdrift = 0.0;
+    energydrift = 0.0;
+    monitorsteps = 0;
+}
+
+// Уходы H и T от начальных значений по состоянию y и строка в monitorfile
+static void monitorrecord(double * y)
+{
+    double H[3], T;
+    conservation(y, H, &T);
+
+    double dh = sqrt((H[0] - monitorH[0])*(H[0] - monitorH[0])
+                   + (H[1] - monitorH[1])*(H[1] - monitorH[1])
+                   + (H[2] - monitorH[2])*(H[2] - monitorH[2]));
+    double h0 = sqrt(monitorH[0]*monitorH[0] + monitorH[1]*monitorH[1] + monitorH[2]*monitorH[2]);
+    dh /= h0;
+    double dt = (T - monitorT)/monitorT;
+
+    if (dh > momentumdrift)
+        momentumdrift = dh;
+    if (fabs(dt) > energydrift)
+        energydrift = fabs(dt);
+
+    if (monitorfile.is_open())
+        monitorfile<<monitorsteps<<" "<<sqrt(H[0]*H[0] + H[1]*H[1] + H[2]*H[2])<<" "<<T
+                   <<" "<<dh<<" "<<dt<<std::endl;
+}
+
+/*************************************************************************
+  Вызывается после каждого шага Рунге-Кутты: каждые monitorevery шагов
+  (flag 1 и 2 - без внешних моментов H и T должны сохраняться) считает
+  уход от начальных значений и пишет строку в monitorfile. С давлением
+  излучения, маховиками или гравитационным моментом уход - не ошибка
+  интегрирования, а работа внешних сил.
+ *************************************************************************/
+void monitorstep(double * y, int flag)
+{
+    if (monitorframes || (flag != 1 && flag != 2))
+        return;
+
+    monitorsteps++;
+    if (monitorsteps % monitorevery != 0)
+        return;
+
+    monitorrecord(y);
+}
+
+/*************************************************************************
+  Состояние y на конце кадра из steps шагов (при monitorframes): уход
+  считается на каждом кадре, номер шага в файле - как у monitorstep.
+ *************************************************************************/
+void monitorframe(double * y, int steps)
+{
+    monitorsteps += steps;
+    monitorrecord(y);
+}
+
+// Начальные значения и наибольшие уходы для контрольной точки
+void monitorcheckpoint(Checkpoint & ck)
+{
+    ckio(ck, &momentumdrift, 1);
+    ckio(ck, &energydrift, 1);
+    ckio(ck, monitorH, 3);
+    ckio(ck, &monitorT, 1);
+    ckio(ck, monitorsteps);
+}
@@ -0,0 +1,26 @@
+#ifndef CONSERVATION_H
+#define CONSERVATION_H
+
+#include <fstream>
+
+extern int monitor;
+
+extern int monitorevery;
+
+extern int monitorframes;
+
+extern double momentumdrift;
+
+extern double energydrift;
+
+extern std::ofstream monitorfile;
+
+void conservation(double * y, double * H, double * T);
+void monitorreset(double * y);
+void monitorstep(double * y, int flag);
+void monitorframe(double * y, int steps);
+
+struct Checkpoint;
+void monitorcheckpoint(Checkpoint & ck);
+
+#endif // CONSERVATION_H
@@ -1,12 +1,35 @@
-#include <stdio.h>
-//#include "stdafx.h"
-#include <math.h>
-#include <iostream>
-#include <cmath>
-#include <stdlib.h>
-#include <fstream>
-
-#include <boost/numeric/mtl/mtl.hpp>
+#include "detector.h"
+#include "parareal.h"
+#include "linear.h"
+#include "adaptive.h"
+#include "chain.h"
+#include "hingestop.h"
+#include "eclipse.h"
+#include "albedo.h"
+#include "sun.h"
+#include "ephemeris.h"
+#include "geopotential.h"
+#include "srp.h"
+#include "adcs.h"
+#include "modal.h"
+#include "reference.h"
+#include "conservation.h"
+#include "golden.h"
+#include "scenario.h"
+#include "runcache.h"
+#include "checkpoint.h"
+#include "binfile.h"
+#include "sweep.h"
+#include "ensemble.h"
+#include "trace.h"
+
+#include <string.h>
+#include <vector>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#include <thread>
 
 mtl::dense2D<double> I2(3,3);
 
@@ -18,19 +41,16 @@ mtl::dense_vector <double> e1(3);
 
 mtl::dense_vector <double> c(3);
 
-mtl::dense_vector<double> f3(double *y);
-
 mtl::dense_vector <double> a1(3);
 
 double sunvec[3];
 
-void ff(double x, double * y, double * f, int flag);
-
-#define M 398600000000000
-#define R 6400000
-
 std::ofstream file;
 
+// Число вычислений правой части (для сравнения интеграторов). Правую
+// часть вызывают и потоки Parareal - счётчик атомарный
+std::atomic<long> rhscalls(0);
+
 using namespace std;
 /*
 double fw1(double x, double * y);
@@ -153,7 +173,7 @@ void step(int n,double x,double h,double * y, int flag)
 	{
 		y[i] = y[i]+(k1[i]+2.0*k2[i]+2.0*k3[i]+k4[i])/6;
 	}
-    if (flag == 1)
+    if (flag >= 1)
 	{
 		double modul = sqrt(y[3]*y[3]+y[4]*y[4]+y[5]*y[5]+y[6]*y[6]);
         if (modul != 0)
@@ -189,6 +209,8 @@ void solvesystemrungekutta(int n,double x,double x1,int steps,double * result, i
 	for(int i = 0; i < steps; i++)
 	{
         step(n, x+i*(x1-x)/steps, (x1-x)/steps, result, flag);
+        if (monitor)
+            monitorstep(result, flag);
 	}
 }
 
@@ -456,6 +478,61 @@ mtl::dense_vector<double> f4(double *y)
     return v;
 }
 
+/*************************************************************************
+  Внешний момент на спутник в связанной системе добавляется к tau:
+  гравитационный момент, давление излучения и маховики. В g - обобщённые
+  силы давления излучения (srpforces), g[3] и g[4] - по углам панели.
+  Тензор инерции в гравитационном моменте считается по углам панели из
+  y; у застопоренной панели (ffrigid) углы не меняются и он равен Ilock.
+ *************************************************************************/
+void bodytorque(double * y, mtl::dense_vector <double> & tau, double * g)
+{
+    using namespace mtl;
+
+    // Гравитационный момент 3M/r^5 (r x B r): r - положение спутника в
+    // связанной системе, B - тензор инерции всей системы (как в S).
+    // Обобщённые силы по углам панели от градиента малы и не учитываются
+    if (gravitygradient)
+    {
+        dense_vector <double> rg(3);
+        int k;
+        for (k=0;k<3;k++)
+            rg(k)=gravityposition[k];
+        dense_vector <double> rb(3);
+        rb=Qmatrix(q(y))*rg;
+        double rn=two_norm(rb);
+
+        // Положение не задано - момента нет (а не деление на ноль)
+        if (rn > 0.0)
+        {
+            dense2D<double> B(3, 3);
+            B=I1+J2(y)+K(dense_vector<double>(a1+alpha2(y)),dense_vector<double>(a1+alpha2(y)));
+
+            tau+=3.0*M/pow(rn,5)*cross(rb, dense_vector <double>(B*rb));
+        }
+    }
+
+    // Давление солнечного излучения на освещённую грань панели
+    if (srp)
+    {
+        srpforces(y, g);
+        tau(0)+=g[0];
+        tau(1)+=g[1];
+        tau(2)+=g[2];
+    }
+
+    // Маховики: момент двигателей (постоянный между тактами регулятора)
+    // и гироскопический член
+    if (adcs)
+    {
+        double w[3];
+        adcstorque(y, w);
+        tau(0)+=w[0];
+        tau(1)+=w[1];
+        tau(2)+=w[2];
+    }
+}
+
 mtl::dense_vector <double> v(double *y)
 {
     using namespace mtl;
@@ -468,9 +545,13 @@ mtl::dense_vector <double> v(double *y)
     v1=0.0;
     v1=-f1(y)-f2(y)-cross(a1, f4(y))-cross(alpha2(y), f4(y));
 
+    // Внешний момент; g - обобщённые силы давления излучения
+    double g[5];
+    bodytorque(y, v1, g);
+
     double v2=-dot(f2(y), e1)-dot(cross(alpha2(y), f4(y)), e1);
 
-    double v3=-dot(f2(y), e3(y))-dot(cross(alpha2(y), f4(y)), dense_vector <double> (trans(B1(y))*e3(y)));
+    double v3=-dot(f2(y), dense_vector <double> (trans(B1(y))*e3(y)))-dot(cross(alpha2(y), f4(y)), dense_vector <double> (trans(B1(y))*e3(y)));
 
     int i;
     for(i=0;i<3;i++)
@@ -481,6 +562,12 @@ mtl::dense_vector <double> v(double *y)
     v(3)=v2;
     v(4)=v3;
 
+    if (srp)
+    {
+        v(3)+=g[3];
+        v(4)+=g[4];
+    }
+
     return v;
 }
 
@@ -551,8 +638,32 @@ mtl::dense2D<double> S(double *y)
 
 void ff(double x, double * y, double * f, int flag)
 {
+    rhscalls.fetch_add(1, std::memory_order_relaxed);
+
+    if (flag == 2)
+    {
+        ffrigid(x, y, f);
+        return;
+    }
+
+    if (flag == 3)
+    {
+        ffchain(x, y, f);
+        return;
+    }
+
+    if (flag == 4)
+    {
+        ffmodal(x, y, f);
+        return;
+    }
+
     if (flag == 1)
     {
+        // Кинетический момент маховиков на момент x (для v(y))
+        if (adcs)
+            adcswheels(x);
+
         mtl::dense_vector <double> omegapsi(5);
         omegapsi = mtl::mat::inv(S(y))*v(y);
 
@@ -579,8 +690,8 @@ void ff(double x, double * y, double * f, int flag)
     for (i=0;i<3;i++)
     {
         f[i] = y[i+3];
-        f[i+3] = (-M*y[i])/pow(pow(y[0],2)+pow(y[1],2)+pow(y[2],2),1.5);
     }
+    geoacceleration(x, y, &f[3]);
     return;
 }
 
@@ -603,17 +714,24 @@ mtl::dense2D<double> Qmatrix(mtl::dense_vector <double> q)
     return B;
 }
 
-mtl::dense_vector <double> Ansi(mtl::dense_vector <double> ai, double * y)
+mtl::dense_vector <double> corner(mtl::dense_vector <double> ai, double * y)
 {
     mtl::dense_vector <double> xi(3);
     xi=0.0;
 
     xi=mtl::dense_vector <double> (trans(B1(y))*mtl::dense_vector <double> (trans(B3(y))*(a2_+ai)));
 
+    return mtl::dense_vector <double> (a1 + xi);
+}
+
+mtl::dense_vector <double> Ansi(mtl::dense_vector <double> ai, double * y)
+{
+    TRACE_ZONE("Ansi");
+
     mtl::dense_vector <double> Ansi(3);
     Ansi=0.0;
 
-    Ansi = mtl::dense_vector <double> (a1 + mtl::dense_vector <double> (xi - c));
+    Ansi = mtl::dense_vector <double> (corner(ai, y) - c);
 
     double temp = Ansi[1];
     Ansi[1]=Ansi[2];
@@ -678,41 +796,498 @@ void vec_print(mtl::dense_vector <double> v)
     return;
 }
 
-int main(int, char**)
+/*************************************************************************
+  Отражённый Землёй свет для кадра: 9 коэффициентов освещённости по
+  сферическим функциям и оси X, Z локальной системы (см. albedo.cc)
+  в координатах vectosun/vectoearth.
+ *************************************************************************/
+void albedo_print(double * y, double * result)
+{
+    double h, phi, X[3], Z[3], coef[9];
+
+    albedoframe(vectosun(y, result), vectoearth(y, result), &h, &phi, X, Z);
+    albedosample(h, phi, coef);
+
+    int i;
+    for (i=0;i<9;i++)
+        file<<coef[i]<<" ";
+    for (i=0;i<3;i++)
+        file<<X[i]<<" ";
+    for (i=0;i<3;i++)
+        file<<Z[i]<<" ";
+}
+
+// Режимы прогона из командной строки - общие для всех сценариев пакета
+struct DetectorOptions
+{
+    int parareal;
+    int linear;
+    int adaptive;
+    int chain;
+    int stops;
+    int ephemeris;
+    int orbitephemeris;
+    int modal;
+    int checkpoint;
+    int restart;
+    const char * cache;
+    Ensemble * stats;
+};
+
+static int detectorrun(const Scenario & sc, const DetectorOptions & opt);
+
+// Углы панели (столбцы 7..30 строки кадра) по строкам файла кадров
+static int cornerrows(const std::string & name, std::vector<std::vector<double> > & rows)
+{
+    std::ifstream in(name.c_str());
+    if (!in)
+        return 0;
+
+    std::string line;
+    while (std::getline(in, line))
+    {
+        std::istringstream row(line);
+        std::vector<double> v;
+        double x;
+        while (row >> x)
+            v.push_back(x);
+        if (v.size() < 31)
+            return 0;
+        rows.push_back(std::vector<double>(v.begin() + 7, v.begin() + 31));
+    }
+    return 1;
+}
+
+/*************************************************************************
+  Проверка переключения моделей (-adaptivecheck): сценарий считается
+  полной моделью и в режиме -adaptive (кадры - в sc.output.full и
+  sc.output.adaptive), наибольшее расхождение углов панели по всем
+  кадрам сравнивается с adaptivetol. Возвращает 0, если оно в допуске.
+ *************************************************************************/
+static int adaptivecompare(const Scenario & sc, const DetectorOptions & opt)
+{
+    Scenario full = sc;
+    Scenario locked = sc;
+    full.output = sc.output + ".full";
+    locked.output = sc.output + ".adaptive";
+
+    DetectorOptions o = opt;
+    o.adaptive = 0;
+    if (detectorrun(full, o))
+        return 1;
+    o.adaptive = 1;
+    if (detectorrun(locked, o))
+        return 1;
+
+    std::vector<std::vector<double> > a, b;
+    if (!cornerrows(full.output, a) || !cornerrows(locked.output, b) || a.size() != b.size())
+    {
+        cerr<<sc.output<<": cannot compare frames"<<endl;
+        return 1;
+    }
+
+    double error = 0.0;
+    size_t j, i;
+    for (j=0;j<a.size();j++)
+    {
+        for (i=0;i<a[j].size();i++)
+            error = std::max(error, fabs(a[j][i] - b[j][i]));
+    }
+
+    int pass = error <= adaptivetol;
+    cout<<"ADAPTIVE CORNER ERROR "<<error<<" m, TOLERANCE "<<adaptivetol<<" m "
+        <<(pass ? "PASS" : "FAIL")<<endl;
+    return pass ? 0 : 1;
+}
+
+/*************************************************************************
+  Итог -stats: к статистике прогонов добавляются файлы -statsmerge
+  (других процессов или пакетов), результат - в name для следующего
+  объединения и таблица в name.txt. Возвращает 0 при ошибке.
+ *************************************************************************/
+static int statssave(const char * name, Ensemble & e, const std::vector<std::string> & merge)
+{
+    size_t k;
+    for (k=0;k<merge.size();k++)
+    {
+        Ensemble other;
+        if (!ensembleload(merge[k].c_str(), other))
+        {
+            cerr<<merge[k]<<": cannot read"<<endl;
+            return 0;
+        }
+        if (e.frames.empty())
+            e = other;
+        else if (!ensemblemerge(e, other))
+        {
+            cerr<<merge[k]<<": output times differ"<<endl;
+            return 0;
+        }
+    }
+    if (e.frames.empty())
+    {
+        cerr<<name<<": no runs"<<endl;
+        return 0;
+    }
+
+    if (!ensemblesave(name, e))
+    {
+        cerr<<name<<": cannot write"<<endl;
+        return 0;
+    }
+    std::ofstream table((std::string(name) + ".txt").c_str());
+    ensembleprint(table, e);
+    cout<<"STATS "<<e.frames[0].n<<" RUNS, "<<e.frames.size()<<" FRAMES -> "<<name<<endl;
+    return 1;
+}
+
+// В программе замеров (bench.pro) main() - своя, эта вызывается из неё
+#ifdef DETECTOR_NO_MAIN
+int detectormain(int argc, char** argv)
+#else
+int main(int argc, char** argv)
+#endif
 {
     using namespace mtl;
 
-//    dense2D<double> I2(3,3);
+    DetectorOptions opt = {0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    int albedobench = 0;
+    int geopotential = 0;
+    int geobench = 0;
+    int integratorbench = 0;
+    int adaptivecmp = 0;
+    int golden = 0;
+    int goldenrec = 0;
+
+    // Сценарии пакета (файлы или каталоги *.scn) и каталог для их кадров
+    std::vector<std::string> scenarios;
+    std::string outdir;
+
+    // Перебор параметров (-sweep) и исполнитель одной его части
+    const char * sweepfile = 0;
+    const char * launchcommand = 0;
+    int workers = (int)std::thread::hardware_concurrency();
+    char ** worker = 0;
+
+    // Статистика ансамбля вместо файлов кадров и файлы для объединения
+    const char * statsfile = 0;
+    std::vector<std::string> statsmerge;
+
+    int arg;
+    for (arg = 1; arg < argc; arg++)
+    {
+        if (strcmp(argv[arg], "-parareal") == 0)
+            opt.parareal = 1;
+        if (strcmp(argv[arg], "-linear") == 0)
+            opt.linear = 1;
+        if (strcmp(argv[arg], "-adaptive") == 0)
+            opt.adaptive = 1;
+        if (strcmp(argv[arg], "-chain") == 0)
+            opt.chain = 1;
+        if (strcmp(argv[arg], "-stops") == 0)
+            opt.stops = 1;
+        if (strcmp(argv[arg], "-albedobench") == 0)
+            albedobench = 1;
+        if (strcmp(argv[arg], "-ephemeris") == 0)
+            opt.ephemeris = 1;
+        if (strcmp(argv[arg], "-orbitephemeris") == 0)
+            opt.orbitephemeris = 1;
+        if (strcmp(argv[arg], "-geopotential") == 0)
+            geopotential = 1;
+        if (strcmp(argv[arg], "-geobench") == 0)
+            geobench = 1;
+        if (strcmp(argv[arg], "-srp") == 0)
+            srp = 1;
+        if (strcmp(argv[arg], "-adcs") == 0)
+            adcs = 1;
+        if (strcmp(argv[arg], "-modal") == 0)
+            opt.modal = 1;
+        if (strcmp(argv[arg], "-integratorbench") == 0)
+            integratorbench = 1;
+        if (strcmp(argv[arg], "-adaptivecheck") == 0)
+            adaptivecmp = 1;
+        if (strcmp(argv[arg], "-monitor") == 0)
+            monitor = 1;
+        if (strcmp(argv[arg], "-golden") == 0)
+            golden = 1;
+        if (strcmp(argv[arg], "-goldenrecord") == 0)
+            goldenrec = 1;
+        if (strcmp(argv[arg], "-scenario") == 0 && arg + 1 < argc)
+        {
+            if (!scenariolist(argv[++arg], scenarios))
+                return 1;
+        }
+        if (strcmp(argv[arg], "-outdir") == 0 && arg + 1 < argc)
+            outdir = argv[++arg];
+        if (strcmp(argv[arg], "-cache") == 0 && arg + 1 < argc)
+            opt.cache = argv[++arg];
+        if (strcmp(argv[arg], "-checkpoint") == 0 && arg + 1 < argc)
+            opt.checkpoint = atoi(argv[++arg]);
+        if (strcmp(argv[arg], "-restart") == 0)
+            opt.restart = 1;
+        if (strcmp(argv[arg], "-sweep") == 0 && arg + 1 < argc)
+            sweepfile = argv[++arg];
+        if (strcmp(argv[arg], "-workers") == 0 && arg + 1 < argc)
+            workers = atoi(argv[++arg]);
+        if (strcmp(argv[arg], "-launcher") == 0 && arg + 1 < argc)
+            launchcommand = argv[++arg];
+        if (strcmp(argv[arg], "-stats") == 0 && arg + 1 < argc)
+            statsfile = argv[++arg];
+        if (strcmp(argv[arg], "-statsmerge") == 0 && arg + 1 < argc)
+            statsmerge.push_back(argv[++arg]);
+        if (strcmp(argv[arg], "-sweepworker") == 0 && arg + 4 < argc)
+        {
+            worker = &argv[arg + 1];
+            arg += 4;
+        }
+    }
+
+    if (albedobench)
+    {
+        albedoinit(ALBEDOFILE);
+        albedobenchmark();
+        return 0;
+    }
 
-//    dense2D<double> I1(3,3);
+    geopotentialinit(0);
+    if (geobench)
+    {
+        geopotentialbenchmark();
+        return 0;
+    }
 
-    file.open("output.txt");
+    // Поле Земли до 8-й степени и гравитационный момент
+    if (geopotential)
+    {
+        geopotentialinit(8);
+        gravitygradient = 1;
+    }
 
-    I1 = 0.0;
-    I1(0,0)= 38.57;
-    I1(1,1)= 29.05;
-    I1(2,2)= 33.96;
+    // Исполнитель части перебора: "-sweepworker <файл> <first> <last> <shard>"
+    if (worker)
+    {
+        Sweep sw;
+        if (!sweepload(worker[0], sw))
+            return 1;
+        return sweepworker(sw, atoi(worker[1]), atoi(worker[2]), worker[3]);
+    }
 
-    I2 = 0.0;
-    I2(0,0)= 5.549;
-    I2(1,1)= 1.757;
-    I2(2,2)= 7.304;
+    // Перебор: части - процессам этой машины (fork) или команде -launcher
+    if (sweepfile)
+    {
+        Sweep sw;
+        if (!sweepload(sweepfile, sw))
+            return 1;
+        SweepLauncher launcher;
+        launcher.start = launchcommand ? sweepcommand : sweepfork;
+        launcher.command = launchcommand;
+        return sweeprun(sw, launcher, std::max(workers, 1), outdir.empty() ? "." : outdir);
+    }
 
-    a2_=0.0;
-    a2_(1)=1.0;
+    // Параметры и начальное состояние прежнего main()
+    Scenario def;
+    scenariodefault(def);
 
-    e1 = 0.0;
-    e1(1) = 1;
+    if (integratorbench || golden || goldenrec)
+    {
+        double y[11+2*MAXMODES];
+        double result[6];
+        scenarioapply(def, y, result);
 
-/*
-    a1(0)=0.0094;
-    a1(1)=-0.4489;
-    a1(2)=-0.1268;
-*/
+        // Интеграторы против точных решений: твёрдое тело и задача двух тел
+        if (integratorbench)
+        {
+            integratorbenchmark(y, result);
+            return 0;
+        }
+
+        // Регрессионная проверка по эталонным траекториям (код завершения -
+        // число непрошедших сценариев) и их перезапись
+        if (goldenrec)
+            return goldenrecord(y, result, GOLDENDIR);
+        return goldencheck(y, result, GOLDENDIR);
+    }
 
-    a1(0)=0.0;
-    a1(1)=0.5;
-    a1(2)=0.0;
+    // Каталог кэша создаётся здесь: иначе каждый прогон писал бы в него
+    // с ошибкой
+    if (opt.cache && !makedirectory(opt.cache))
+    {
+        cerr<<opt.cache<<": cannot create cache directory"<<endl;
+        return 1;
+    }
+
+    // Parareal считает кадры заранее моделью панели на шарнире (flag 1)
+    // в нескольких потоках: другие модели и регулятор ADCS (его
+    // глобальное состояние) с ним не сочетаются
+    if (opt.parareal && (opt.linear || opt.adaptive || adaptivecmp || opt.chain
+                         || opt.stops || opt.modal || adcs))
+    {
+        cerr<<"-parareal cannot be combined with -linear, -adaptive, -chain, -stops, -modal or -adcs"<<endl;
+        return 1;
+    }
+
+    // Такты регулятора ADCS идут только в solvesystemadcs (модель панели
+    // на шарнире): в других моделях момент маховиков остался бы нулевым
+    if (adcs && (opt.linear || opt.adaptive || adaptivecmp || opt.chain || opt.stops || opt.modal))
+    {
+        cerr<<"-adcs cannot be combined with -linear, -adaptive, -chain, -stops or -modal"<<endl;
+        return 1;
+    }
+
+    // Статистика копится по всем прогонам пакета; контрольные точки её не
+    // сохраняют. -statsmerge без сценариев - только объединение файлов.
+    Ensemble ensemble;
+    if (statsfile)
+    {
+        if (opt.checkpoint || opt.restart)
+        {
+            cerr<<"-stats cannot be combined with -checkpoint or -restart"<<endl;
+            return 1;
+        }
+        if (!statsmerge.empty() && scenarios.empty())
+            return statssave(statsfile, ensemble, statsmerge) ? 0 : 1;
+        opt.stats = &ensemble;
+    }
+
+    if (scenarios.empty())
+    {
+        int status = adaptivecmp ? adaptivecompare(def, opt) : detectorrun(def, opt);
+        if (statsfile && status == 0 && !statssave(statsfile, ensemble, statsmerge))
+            status = 1;
+        TRACE_SAVE("detector_trace.json");
+        return status;
+    }
+
+    // Пакет: таблицы выше построены один раз на все сценарии
+    auto t0 = std::chrono::steady_clock::now();
+    int failed = 0;
+    size_t k;
+    for (k=0;k<scenarios.size();k++)
+    {
+        Scenario sc;
+        scenariodefault(sc);
+        if (!scenarioload(scenarios[k].c_str(), sc))
+        {
+            failed++;
+            continue;
+        }
+        if (!outdir.empty())
+            sc.output = outdir + "/" + sc.output;
+
+        cout<<"SCENARIO "<<sc.name<<" "<<sc.output<<endl;
+        failed += adaptivecmp ? adaptivecompare(sc, opt) : detectorrun(sc, opt);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    cout<<"SCENARIOS "<<scenarios.size() - failed<<" OF "<<scenarios.size()<<" IN "
+        <<std::chrono::duration<double>(t1 - t0).count()<<" s"<<endl;
+    if (opt.cache)
+        cout<<"CACHE HITS "<<runcachehits<<" PARTIAL "<<runcachepartial
+            <<" MISSES "<<runcachemisses<<endl;
+    if (statsfile && !statssave(statsfile, ensemble, statsmerge))
+        failed++;
+    TRACE_SAVE("detector_trace.json");
+    return failed ? 1 : 0;
+}
+
+/*************************************************************************
+  Контрольная точка прогона на границе кадров: номер следующего кадра,
+  вектор состояния, текущая модель адаптивного режима, точка линеаризации
+  с матрицей перехода, длины файла кадров и conservation.txt и состояние
+  модулей. Одна и та же функция пишет (ck.restore = 0) и читает точку.
+  Время - frame*next, орбита, эфемериды и освещённость строятся заново
+  тем же кодом и совпадают побитно.
+ *************************************************************************/
+static void runcheckpoint(Checkpoint & ck, int & next, double * y, int n, int & model,
+                          double * ys, mtl::dense2D<double> & E, int & linearok, int & relinearizations,
+                          int & fallbacks, long & fileoffset, long & monitoroffset)
+{
+    ckio(ck, next);
+    ckio(ck, y, n);
+    ckio(ck, model);
+    ckio(ck, ys, 11);
+
+    int i, j;
+    for (i=0;i<12;i++)
+    {
+        for (j=0;j<12;j++)
+        {
+            double v = E(i,j);
+            ckio(ck, &v, 1);
+            E(i,j) = v;
+        }
+    }
+
+    ckio(ck, linearok);
+    ckio(ck, relinearizations);
+    ckio(ck, fallbacks);
+    ckio(ck, fileoffset);
+    ckio(ck, monitoroffset);
+    checkpointmodules(ck);
+}
+
+// Запись контрольной точки перед кадром next: файлы сбрасываются на диск,
+// чтобы их длины соответствовали состоянию
+static int runcheckpointsave(const std::string & name, const std::vector<double> & key,
+                             int next, double * y, int n, int model, double * ys,
+                             mtl::dense2D<double> & E, int linearok, int relinearizations, int fallbacks)
+{
+    TRACE_ZONE("checkpoint");
+    file.flush();
+    long fileoffset = (long)file.tellp();
+    long monitoroffset = 0;
+    if (monitorfile.is_open())
+    {
+        monitorfile.flush();
+        monitoroffset = (long)monitorfile.tellp();
+    }
+
+    Checkpoint ck;
+    ck.restore = 0;
+    ck.failed = 0;
+    ck.pos = 0;
+    runcheckpoint(ck, next, y, n, model, ys, E, linearok, relinearizations, fallbacks,
+                  fileoffset, monitoroffset);
+    return checkpointsave(name, key, ck);
+}
+
+// Кадры прогона для Parareal: окружение части j (положение спутника для
+// гравитационного момента, Солнце и освещённость для давления
+// излучения) - то же, что у кадра j при интегрировании кадр за кадром
+static const double * trackorbit = 0;
+static const double * tracksun = 0;
+static const double * trackfrac = 0;
+
+static void trackat(int j)
+{
+    int i;
+    for (i=0;i<3;i++)
+        gravityposition[i]=trackorbit[j*6+i];
+    srpsun(&tracksun[j*3], &trackorbit[j*6], trackfrac[j]);
+}
+
+/*************************************************************************
+  Прогон одного сценария: кадры в sc.output, итоги в cout. Возвращает 0
+  или 1, если файл кадров не открылся или контрольная точка испорчена.
+ *************************************************************************/
+static int detectorrun(const Scenario & sc, const DetectorOptions & opt)
+{
+    using namespace mtl;
+
+    // При продолжении (-restart) файлы не очищаются: они обрезаются до
+    // длины на момент контрольной точки
+    // С -stats кадры в файл не пишутся. Таблица отражённого Землёй света
+    // нужна только кадрам: строится один раз и хранится в albedo.bin
+    if (!opt.stats)
+    {
+        albedoinit(ALBEDOFILE);
+
+        file.open(sc.output.c_str(), opt.restart ? std::ios::app : std::ios::out);
+        if (!file)
+        {
+            cerr<<sc.output<<": cannot open"<<endl;
+            return 1;
+        }
+    }
 
 /**************************************************************************/
 /*
@@ -733,20 +1308,10 @@ int main(int, char**)
     std::cout << "B is \n" << mat::inv(A) << "\n";
 */
 
-    double y[11];
+    // Параметры модели - в глобальные I1, I2, a1, a2_, e1, c, sunvec
+    double y[11+2*MAXMODES];
     double result[6];
-
-    //Задаём направление на Солнце
-    sunvec[0] = 0;
-    sunvec[1] = 150000000000;
-    sunvec[2] = 0;
-
-    result[0] = 0;
-    result[1] = 6500000;
-    result[2] = 0;
-    result[3] = sqrt(M/6500000);
-    result[4] = 0;
-    result[5] = 0;
+    scenarioapply(sc, y, result);
 /*
     solvesystemrungekutta(6,0,3.1415,10000,result, 0);
     for(int i = 0; i < 6; i++){
@@ -758,20 +1323,9 @@ int main(int, char**)
     else
         cout<<"BRIGHT SIDE"<<endl;
 */
-    y[0]=0.001;
-    y[1]=0.001;
-    y[2]=0.001;
-
-    y[3]=1.0;
-    y[4]=0.0;
-    y[5]=0.0;
-    y[6]=0.0;
-
-    y[7]=0.0;
-    y[8]=0.0;
-
-    y[9]=0.001;
-    y[10]=0.001;
+    // Упругие формы панели: в начале не возбуждены (scenarioapply)
+    if (opt.modal)
+        modalinit(sc.modes);
 
 
     dense_vector <double> d1(3);
@@ -816,29 +1370,367 @@ int main(int, char**)
     d8(1)=-1.0;
     d8(2)=-0.01;
 
-    c(0)=0.0;
-    c(1)=0.5;
-    c(2)=0.5;
+    if (opt.chain)
+        chainfrompanel();
+
+    // Давление излучения - на грань панели d1, d3, d2 (вторая грань ей
+    // параллельна, освещённая сторона выбирается по направлению на Солнце)
+    srpface(d1, d3, d2);
+
+    // Упоры шарнира и точки касания корпуса - из сценария
+    if (opt.stops)
+        stopsinit(sc);
+
+    // Счётчики итогов - свои у каждого сценария пакета
+    impacts=0;
+    contacts=0;
+    switches=0;
+    unlockedtime=lockhorizon;
 
     int j;
     int light=0;
+    int frames=sc.frames;
+    double frame=sc.frame;
+
+    // Моменты вывода всех прогонов ансамбля должны совпадать
+    double eclipse=0.0;
+    if (opt.stats)
+    {
+        if (opt.stats->frames.empty())
+            ensembleinit(*opt.stats, frames/sc.every, frame*sc.every);
+        if ((int)opt.stats->frames.size() != frames/sc.every || opt.stats->frame != frame*sc.every)
+        {
+            cerr<<sc.name<<": output times differ from the ensemble"<<endl;
+            return 1;
+        }
+    }
+
+    if (adcs)
+        adcsreset(0);
 
-    for (j=0;j<150;j++)
+    // Уход кинетического момента и энергии - рядом с траекторией; у
+    // Parareal и линейной модели - по кадрам
+    monitorframes = opt.parareal || opt.linear;
+    if (monitor)
     {
-        solvesystemrungekutta(6,0,10,10,result, 0);
+        monitorfile.open("conservation.txt", opt.restart ? std::ios::app : std::ios::out);
+        monitorreset(y);
+    }
 
-        if((dist_pl(sunvec, result) < R)&&((sunvec[0]*result[0]+sunvec[1]*result[1]+sunvec[2]*result[2]) < 0))
+    // Текущая модель в адаптивном режиме: 1 - панель на шарнире,
+    // 2 - застопоренная панель
+    int model=1;
+
+    // Кэш прогонов (-cache): состояние на концах кадров [0, start) берётся
+    // из прогона с тем же ключом, дальше интегрирование продолжается с
+    // последнего из них. Режимы со своим внутренним состоянием (упоры,
+    // переключение моделей, ADCS, Parareal, линейная модель) и эфемериды,
+    // зависящие от длины прогона, кэш не используют.
+    int n = opt.modal ? 11+2*nmodes : 11;
+    int cols = 6+n;
+    int cacheable = opt.cache && !(opt.parareal || opt.linear || opt.adaptive || opt.stops
+                                   || opt.chain || opt.ephemeris || opt.orbitephemeris
+                                   || adcs || monitor || opt.checkpoint || opt.restart);
+    std::vector<double> cachekey;
+    std::vector<double> rows;
+    int start = 0;
+    if (cacheable)
+    {
+        runcachekey(sc, n, cachekey);
+        start = runcacheload(opt.cache, cachekey, cols, rows);
+        if (start >= frames)
         {
-            file <<"0 ";//<<endl;;
-            light=0;
+            start = frames;
+            runcachehits++;
+            cout<<"CACHE HIT "<<frames<<" FRAMES"<<endl;
+        }
+        else if (start > 0)
+        {
+            runcachepartial++;
+            cout<<"CACHE PARTIAL "<<start<<" OF "<<frames<<" FRAMES"<<endl;
         }
         else
         {
-            file <<"1 ";
-            light=1;
+            runcachemisses++;
+            cout<<"CACHE MISS"<<endl;
         }
+        rows.resize(frames*cols);
+    }
 
-        solvesystemrungekutta(11,0,10,10,y, 1);
+    // Орбита от углового движения не зависит: считаем её на все кадры
+    // заранее, а освещённость - одним вызовом по всему массиву
+    std::vector<double> orbit(frames*6);
+    std::vector<double> ox(frames), oy(frames), oz(frames);
+    std::vector<double> sun(frames*3);
+    std::vector<double> sx(frames), sy(frames), sz(frames);
+    std::vector<double> frac(frames);
+
+    // С эфемеридой Солнце движется: положение на момент кадра берётся из
+    // чебышёвской аппроксимации аналитической теории
+    if (opt.ephemeris)
+    {
+        sunfit(0, frames*frame);
+        cout<<"SUN EPHEMERIS ERROR "<<sunchebyshev.error<<" m"<<endl;
+    }
+
+    // Эфемерида орбиты: интегрируем один раз на весь интервал, дальше
+    // состояние на любой момент берётся из коэффициентов. Они же - в
+    // sc.output.orbit.bin рядом с кадрами сценария (читает chebload)
+    if (opt.orbitephemeris)
+    {
+        orbitfit(result, 0, frames*frame, 300, 12, 1.0);
+        std::string orbitname = sc.output + ".orbit.bin";
+        if (!chebsave(orbitchebyshev, orbitname.c_str()))
+            cerr<<orbitname<<": cannot write"<<endl;
+        cout<<"ORBIT EPHEMERIS ERROR "<<orbitchebyshev.error<<" m, "
+            <<orbitchebyshev.c.size()<<" COEFFICIENTS FOR "<<frames*6<<" SAMPLES"<<endl;
+    }
+
+    {
+        TRACE_ZONE("orbit");
+        int i;
+        for (j=0;j<frames;j++)
+        {
+            if (j < start)
+            {
+                for (i=0;i<6;i++)
+                    result[i]=rows[j*cols+i];
+            }
+            else if (opt.orbitephemeris)
+                orbitat(frame*(j+1), result);
+            else
+                solvesystemrungekutta(6,frame*j,frame*(j+1),sc.orbitsteps,result, 0);
+
+            for (i=0;i<6;i++)
+                orbit[j*6+i]=result[i];
+            ox[j]=result[0];
+            oy[j]=result[1];
+            oz[j]=result[2];
+
+            if (opt.ephemeris)
+                sunat(frame*(j+1), &sun[j*3]);
+            else
+            {
+                for (i=0;i<3;i++)
+                    sun[j*3+i]=sunvec[i];
+            }
+            sx[j]=sun[j*3];
+            sy[j]=sun[j*3+1];
+            sz[j]=sun[j*3+2];
+        }
+        illuminationbatch(frames, &ox[0], &oy[0], &oz[0], &sx[0], &sy[0], &sz[0], &frac[0]);
+    }
+
+    // В режиме Parareal угловое движение на всех кадрах считается
+    // заранее, кадры - границы частей по времени
+    double * Y = 0;
+    if (opt.parareal)
+    {
+        Y = new double[(frames+1)*11];
+        for (j=0;j<11;j++)
+            Y[j]=y[j];
+        trackorbit = &orbit[0];
+        tracksun = &sun[0];
+        trackfrac = &frac[0];
+        int iter = solvesystemparareal(11,0,frames*frame,frames,sc.steps,1,Y,1,1e-10,frames,trackat);
+        cout<<"PARAREAL ITERATIONS "<<iter<<endl;
+    }
+
+    // Линейная модель: точка линеаризации ys - состояние целиком, со
+    // скоростями (свободный столбец E учитывает, что это не равновесие).
+    // linearok: -1 - точки ещё нет, 0 - линейная модель в ней неточна
+    // и кадры считаются нелинейно, 1 - кадры - скачки E
+    double ys[11];
+    dense2D <double> E(12,12);
+    E = 0.0;
+    int linearok=-1;
+    int fallbacks=0;
+    int relinearizations=0;
+    for (j=0;j<11;j++)
+        ys[j]=y[j];
+
+    // Контрольные точки (-checkpoint N): каждые N кадров в sc.output.ckpt.
+    // Ключ - ключ кэша с режимами прогона, числом кадров и шагом вывода,
+    // так что -restart не продолжит другой прогон.
+    int first = 0;
+    int ckn = opt.chain ? 7+2*chaindof() : n;
+    std::string ckname = sc.output + ".ckpt";
+    std::vector<double> ckkey;
+    if (opt.checkpoint > 0 || opt.restart)
+    {
+        runcachekey(sc, ckn, ckkey);
+        ckkey.push_back(opt.parareal);
+        ckkey.push_back(opt.linear);
+        ckkey.push_back(opt.adaptive);
+        ckkey.push_back(opt.chain);
+        ckkey.push_back(opt.stops);
+        ckkey.push_back(opt.ephemeris);
+        ckkey.push_back(opt.orbitephemeris);
+        ckkey.push_back(opt.modal);
+        ckkey.push_back(adcs);
+        ckkey.push_back(monitor);
+        ckkey.push_back(frames);
+        ckkey.push_back(sc.every);
+        if (opt.stops)
+        {
+            int k;
+            for (k=0;k<2;k++)
+            {
+                ckkey.push_back(sc.psimin[k]);
+                ckkey.push_back(sc.psimax[k]);
+            }
+            ckkey.push_back(sc.contacts);
+            for (k=0;k<sc.contacts;k++)
+            {
+                ckkey.push_back(sc.contact[k][0]);
+                ckkey.push_back(sc.contact[k][1]);
+                ckkey.push_back(sc.contact[k][2]);
+            }
+        }
+    }
+    if (opt.restart)
+    {
+        Checkpoint ck;
+        long fileoffset = 0;
+        long monitoroffset = 0;
+        if (checkpointload(ckname, ckkey, ck))
+        {
+            runcheckpoint(ck, first, y, ckn, model, ys, E, linearok, relinearizations, fallbacks,
+                          fileoffset, monitoroffset);
+            if (ck.failed || ck.pos != ck.data.size() || first < 0 || first > frames)
+            {
+                cerr<<ckname<<": damaged checkpoint"<<endl;
+                delete[] Y;
+                file.close();
+                if (monitorfile.is_open())
+                    monitorfile.close();
+                return 1;
+            }
+        }
+
+        // Без контрольной точки - прогон с начала
+        file.flush();
+        truncatefile(sc.output.c_str(), fileoffset);
+        file.seekp(0, std::ios::end);
+        if (monitorfile.is_open())
+        {
+            monitorfile.flush();
+            truncatefile("conservation.txt", monitoroffset);
+            monitorfile.seekp(0, std::ios::end);
+        }
+        cout<<"RESTART FROM FRAME "<<first<<endl;
+    }
+
+    for (j=first;j<frames;j++)
+    {
+        if (opt.checkpoint > 0 && j > first && j % opt.checkpoint == 0)
+        {
+            if (!runcheckpointsave(ckname, ckkey, j, y, ckn, model, ys, E, linearok, relinearizations, fallbacks))
+                cerr<<ckname<<": cannot write"<<endl;
+        }
+
+        TRACE_ZONE("frame");
+        int i;
+        for (i=0;i<6;i++)
+            result[i]=orbit[j*6+i];
+        for (i=0;i<3;i++)
+        {
+            sunvec[i]=sun[j*3+i];
+            gravityposition[i]=result[i];
+        }
+        srpsun(sunvec, result, frac[j]);
+        light = (frac[j] > 0) ? 1 : 0;
+
+        {
+            TRACE_ZONE("integrate");
+            if (j < start)
+            {
+                for (i=0;i<n;i++)
+                    y[i]=rows[j*cols+6+i];
+            }
+            else if (opt.parareal)
+            {
+                for (i=0;i<11;i++)
+                    y[i]=Y[(j+1)*11+i];
+            }
+            else if (opt.linear)
+            {
+                // Состояние ушло от точки линеаризации дальше lineartol -
+                // переносим точку в него. Ошибка модели в новой точке -
+                // кадр нелинейной модели против скачка E из неё же; сам
+                // кадр берётся из нелинейного решения, а дальше, если
+                // ошибка больше linearerror, кадры считаются нелинейно
+                // до следующего переноса точки
+                if (linearok < 0 || lineardeviation(ys, y) > lineartol)
+                {
+                    double yn[11];
+                    for (i=0;i<11;i++)
+                    {
+                        ys[i]=y[i];
+                        yn[i]=y[i];
+                    }
+                    E = lineartransition(ys,frame);
+                    relinearizations++;
+
+                    solvesystemrungekutta(11,0,frame,sc.steps,yn, 1);
+                    linearjump(E, ys, y);
+                    linearok = (lineardeviation(yn, y) <= linearerror) ? 1 : 0;
+                    for (i=0;i<11;i++)
+                        y[i]=yn[i];
+                    if (!linearok)
+                        fallbacks++;
+                }
+                else if (linearok)
+                    linearjump(E, ys, y);
+                else
+                {
+                    solvesystemrungekutta(11,0,frame,sc.steps,y, 1);
+                    fallbacks++;
+                }
+            }
+            else if (opt.stops)
+                solvesystemstops(11,0,frame,sc.steps,y, 1);
+            else if (opt.chain)
+                solvesystemrungekutta(7+2*chaindof(),0,frame,sc.steps,y, 3);
+            else if (opt.adaptive)
+                solvesystemadaptive(11,0,frame,sc.steps,y,&model);
+            else if (adcs)
+                solvesystemadcs(11,frame*j,frame*(j+1),sc.steps,y, 1);
+            else if (opt.modal)
+                solvesystemrungekutta(11+2*nmodes,0,frame,std::max(modalsteps(frame),sc.steps),y, 4);
+            else
+                solvesystemrungekutta(11,0,frame,sc.steps,y, 1);
+        }
+        TRACE_COUNTER("rhs", rhscalls.load());
+        if (monitor && monitorframes)
+            monitorframe(y, sc.steps);
+
+        if (cacheable)
+        {
+            for (i=0;i<6;i++)
+                rows[j*cols+i]=result[i];
+            for (i=0;i<n;i++)
+                rows[j*cols+6+i]=y[i];
+        }
+
+        // Время в тени с начала прогона - для статистики ансамбля
+        eclipse += (1.0 - frac[j])*frame;
+
+        // В файл - каждый every-й кадр
+        if ((j+1) % sc.every != 0)
+            continue;
+
+        // С -stats вместо строки кадра - добавление в статистику
+        if (opt.stats)
+        {
+            ensembleadd(*opt.stats, (j+1)/sc.every - 1, y, eclipse);
+            continue;
+        }
+
+        TRACE_ZONE("output");
+
+        // Доля видимого солнечного диска вместо признака 0/1
+        file <<frac[j]<<" ";
 
         dense_vector <double> temp(3);
         temp = 0.0;
@@ -855,6 +1747,9 @@ int main(int, char**)
             vec_print(Ansi(d6, y));
             vec_print(Ansi(d7, y));
             vec_print(Ansi(d8, y));
+            albedo_print(y, result);
+            if (opt.modal)
+                modal_print(y);
             file<<endl;
         }
         else
@@ -869,10 +1764,48 @@ int main(int, char**)
             vec_print(temp);
             vec_print(temp);
             vec_print(temp);
+            albedo_print(y, result);
+            if (opt.modal)
+                modal_print(y);
             file<<endl;
         }
     }
+    if (opt.checkpoint > 0 && frames > first)
+    {
+        if (!runcheckpointsave(ckname, ckkey, frames, y, ckn, model, ys, E, linearok, relinearizations, fallbacks))
+            cerr<<ckname<<": cannot write"<<endl;
+    }
     file.close();
+    delete[] Y;
+    if (cacheable && start < frames)
+    {
+        if (!runcachesave(opt.cache, cachekey, frames, cols, rows))
+            cerr<<runcachename(opt.cache, cachekey)<<": cannot write"<<endl;
+    }
+    if (opt.stops)
+    {
+        cout<<"IMPACTS "<<impacts<<endl;
+        cout<<"RESTING CONTACTS "<<contacts<<endl;
+    }
+    if (opt.adaptive)
+        cout<<"MODEL SWITCHES "<<switches<<endl;
+    if (adcs)
+    {
+        cout<<"CONTROLLER TICKS "<<adcsticks<<endl;
+        cout<<"POINTING ERROR "<<adcserror(y)*180.0/M_PI<<" deg"<<endl;
+        cout<<"WHEEL MOMENTUM "<<wheelmomentum[0]<<" "<<wheelmomentum[1]<<" "<<wheelmomentum[2]<<endl;
+    }
+    if (monitor)
+    {
+        monitorfile.close();
+        cout<<"MOMENTUM DRIFT "<<momentumdrift<<endl;
+        cout<<"ENERGY DRIFT "<<energydrift<<endl;
+    }
+    if (opt.linear)
+    {
+        cout<<"RELINEARIZATIONS "<<relinearizations<<endl;
+        cout<<"NONLINEAR FALLBACKS "<<fallbacks<<endl;
+    }
     cout<<"FINISH"<<endl;
     return 0;
 }
@@ -0,0 +1,68 @@
+#ifndef DETECTOR_H
+#define DETECTOR_H
+
+#include <stdio.h>
+#include <math.h>
+#include <iostream>
+#include <cmath>
+#include <stdlib.h>
+#include <fstream>
+#include <atomic>
+
+#include <boost/numeric/mtl/mtl.hpp>
+
+#define M 398600000000000
+#define R 6400000
+
+extern mtl::dense2D<double> I2;
+
+extern mtl::dense2D<double> I1;
+
+extern mtl::dense_vector <double> a2_;
+
+extern mtl::dense_vector <double> e1;
+
+extern mtl::dense_vector <double> c;
+
+extern mtl::dense_vector <double> a1;
+
+extern double sunvec[3];
+
+extern std::ofstream file;
+
+extern std::atomic<long> rhscalls;
+
+void step(int n,double x,double h,double * y, int flag);
+void solvesystemrungekutta(int n,double x,double x1,int steps,double * result, int flag);
+double dist_pl(double sunvec[3], double result[6]);
+
+void ff(double x, double * y, double * f, int flag);
+
+mtl::dense2D<double> K(mtl::dense_vector <double> a, mtl::dense_vector <double> b);
+mtl::dense2D<double> OMEGA(double *y);
+mtl::dense_vector<double> q(double *y);
+mtl::dense_vector<double> dq(double *y);
+mtl::dense2D<double> B3(double *y);
+mtl::dense2D<double> B1(double *y);
+mtl::dense2D<double> J2(double *y);
+mtl::dense_vector<double> alpha2(double *y);
+mtl::dense_vector<double> omega1(double *y);
+mtl::dense_vector<double> f1(double *y);
+mtl::dense_vector<double> e3(double *y);
+mtl::dense_vector<double> w2(double *y);
+mtl::dense_vector<double> f2(double *y);
+mtl::dense_vector<double> f3(double *y);
+mtl::dense_vector<double> f4(double *y);
+void bodytorque(double * y, mtl::dense_vector <double> & tau, double * g);
+mtl::dense_vector <double> v(double *y);
+mtl::dense2D<double> S(double *y);
+
+mtl::dense2D<double> Qmatrix(mtl::dense_vector <double> q);
+mtl::dense_vector <double> corner(mtl::dense_vector <double> ai, double * y);
+mtl::dense_vector <double> Ansi(mtl::dense_vector <double> ai, double * y);
+mtl::dense_vector <double> r(double * result);
+mtl::dense_vector <double> vectosun(double * y, double * result);
+mtl::dense_vector <double> vectoearth(double * y, double * result);
+void vec_print(mtl::dense_vector <double> v);
+
+#endif // DETECTOR_H
@@ -0,0 +1,102 @@
+#include "detector.h"
+#include "eclipse.h"
+
+/*************************************************************************
+  arccos по Абрамовицу и Стигану (4.4.46), погрешность 2e-8. В отличие
+  от acos из libm векторизуется: только умножения, сложения и sqrt.
+ *************************************************************************/
+static inline double clamp(double v, double lo, double hi)
+{
+    v = (v < lo) ? lo : v;
+    return (v > hi) ? hi : v;
+}
+
+static inline double arccos(double x)
+{
+    double ax = fabs(x);
+    double p = -0.0012624911;
+    p = p*ax + 0.0066700901;
+    p = p*ax - 0.0170881256;
+    p = p*ax + 0.0308918810;
+    p = p*ax - 0.0501743046;
+    p = p*ax + 0.0889789874;
+    p = p*ax - 0.2145988016;
+    p = p*ax + 1.5707963050;
+    double r = sqrt(1.0 - ax)*p;
+
+    // Для x<0 arccos(x) = pi - arccos(-x)
+    return M_PI/2 - copysign(M_PI/2 - r, x);
+}
+
+static inline double arcsin(double x)
+{
+    return M_PI/2 - arccos(x);
+}
+
+/*************************************************************************
+  Коническая модель тени Земли (умбра и полутень).
+
+  Из точки спутника Солнце и Земля видны дисками с угловыми радиусами
+  as = asin(RS/|sun-r|) и ae = asin(R/|r|), центры дисков разнесены на
+  угол c. Возвращается видимая доля солнечного диска:
+    c >= as+ae      - 1, Солнце открыто;
+    c <= ae-as      - 0, умбра;
+    c <= as-ae      - 1-(ae/as)^2, кольцевое затмение;
+    иначе           - 1 - (площадь пересечения дисков)/(pi*as^2).
+ *************************************************************************/
+static inline double visiblefraction(double rx, double ry, double rz,
+                                     double sx, double sy, double sz)
+{
+    double dx = sx - rx;
+    double dy = sy - ry;
+    double dz = sz - rz;
+
+    double rn = sqrt(rx*rx + ry*ry + rz*rz);
+    double dn = sqrt(dx*dx + dy*dy + dz*dz);
+
+    double as = arcsin(clamp(RS/dn, 0.0, 1.0));
+    double ae = arcsin(clamp(R/rn, 0.0, 1.0));
+
+    // Угол между направлениями на Солнце и на центр Земли
+    double cosc = -(dx*rx + dy*ry + dz*rz)/(dn*rn);
+    double cc = arccos(clamp(cosc, -1.0, 1.0));
+
+    // Площадь пересечения дисков; аргументы обрезаны, чтобы формула
+    // считалась без ветвлений и во всех остальных случаях
+    double cs = (cc > 1e-12) ? cc : 1e-12;
+    double x = (cs*cs + as*as - ae*ae)/(2.0*cs);
+    double yy = sqrt(clamp(as*as - x*x, 0.0, as*as));
+    double area = as*as*arccos(clamp(x/as, -1.0, 1.0))
+                + ae*ae*arccos(clamp((cs - x)/ae, -1.0, 1.0))
+                - cs*yy;
+
+    double frac = 1.0 - area/(M_PI*as*as);
+
+    frac = (cc <= as - ae) ? 1.0 - (ae*ae)/(as*as) : frac;
+    frac = (cc <= ae - as) ? 0.0 : frac;
+    frac = (cc >= as + ae) ? 1.0 : frac;
+
+    return clamp(frac, 0.0, 1.0);
+}
+
+double illumination(double * sun, double * result)
+{
+    return visiblefraction(result[0], result[1], result[2], sun[0], sun[1], sun[2]);
+}
+
+/*************************************************************************
+  То же для массива положений спутника и Солнца (раздельные массивы
+  координат). Тело цикла без ветвлений и вызовов libm, так что компилятор
+  векторизует его целиком (-O3 -fopenmp-simd, а -fno-math-errno и
+  -fno-trapping-math разрешают sqrt и сравнения в векторном виде).
+ *************************************************************************/
+void illuminationbatch(int count, const double * x, const double * y, const double * z,
+                       const double * sx, const double * sy, const double * sz, double * frac)
+{
+    int i;
+#pragma omp simd
+    for (i = 0; i < count; i++)
+    {
+        frac[i] = visiblefraction(x[i], y[i], z[i], sx[i], sy[i], sz[i]);
+    }
+}
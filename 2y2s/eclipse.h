@@ -0,0 +1,11 @@
+#ifndef ECLIPSE_H
+#define ECLIPSE_H
+
+// Радиус Солнца, м
+#define RS 696000000.0
+
+double illumination(double * sun, double * result);
+void illuminationbatch(int count, const double * x, const double * y, const double * z,
+                       const double * sx, const double * sy, const double * sz, double * frac);
+
+#endif // ECLIPSE_H
@@ -0,0 +1,193 @@
+#include "detector.h"
+#include "ensemble.h"
+#include "binfile.h"
+
+#include <stdio.h>
+#include <algorithm>
+
+// Признак файла статистики ("ENS1")
+#define ENSEMBLEMAGIC 0x31534e45
+
+void ensembleinit(Ensemble & e, int frames, double frame)
+{
+    EnsembleFrame f;
+    int i;
+    f.n = 0.0;
+    for (i=0;i<2;i++)
+    {
+        f.mean[i] = 0.0;
+        f.ratemin[i] = 1e300;
+        f.ratemax[i] = -1e300;
+    }
+    for (i=0;i<3;i++)
+        f.C[i] = 0.0;
+    f.eclipse = 0.0;
+    f.eclipseM2 = 0.0;
+    f.eclipsemin = 1e300;
+    f.eclipsemax = -1e300;
+    for (i=0;i<ENSEMBLEBINS;i++)
+        f.hist[i] = 0.0;
+
+    e.frame = frame;
+    e.frames.assign(frames, f);
+}
+
+/*************************************************************************
+  Состояние прогона в момент вывода k (время frame*(k+1)): y - вектор
+  состояния, eclipse - время в тени с начала прогона, с. Обновление
+  Уэлфорда: среднее сдвигается на отклонение/n, суммы произведений
+  отклонений копятся по старому и новому среднему.
+ *************************************************************************/
+void ensembleadd(Ensemble & e, int k, const double * y, double eclipse)
+{
+    EnsembleFrame & f = e.frames[k];
+    f.n += 1.0;
+
+    double d0 = y[7] - f.mean[0];
+    double d1 = y[8] - f.mean[1];
+    f.mean[0] += d0/f.n;
+    f.mean[1] += d1/f.n;
+    f.C[0] += d0*(y[7] - f.mean[0]);
+    f.C[1] += d0*(y[8] - f.mean[1]);
+    f.C[2] += d1*(y[8] - f.mean[1]);
+
+    double de = eclipse - f.eclipse;
+    f.eclipse += de/f.n;
+    f.eclipseM2 += de*(eclipse - f.eclipse);
+    if (eclipse < f.eclipsemin)
+        f.eclipsemin = eclipse;
+    if (eclipse > f.eclipsemax)
+        f.eclipsemax = eclipse;
+
+    int bin = (int)(eclipse/(e.frame*(k+1))*ENSEMBLEBINS);
+    if (bin < 0)
+        bin = 0;
+    if (bin > ENSEMBLEBINS-1)
+        bin = ENSEMBLEBINS-1;
+    f.hist[bin] += 1.0;
+
+    int i;
+    for (i=0;i<2;i++)
+    {
+        if (y[9+i] < f.ratemin[i])
+            f.ratemin[i] = y[9+i];
+        if (y[9+i] > f.ratemax[i])
+            f.ratemax[i] = y[9+i];
+    }
+}
+
+/*************************************************************************
+  Объединение статистик (потоков, процессов, пакетов) по формулам Чана:
+  результат тот же, что при добавлении всех прогонов b в a. Возвращает 0,
+  если разбиение по времени разное.
+ *************************************************************************/
+int ensemblemerge(Ensemble & a, const Ensemble & b)
+{
+    if (a.frames.size() != b.frames.size() || a.frame != b.frame)
+        return 0;
+
+    size_t k;
+    int i;
+    for (k=0;k<a.frames.size();k++)
+    {
+        EnsembleFrame & f = a.frames[k];
+        const EnsembleFrame & g = b.frames[k];
+        if (g.n == 0.0)
+            continue;
+
+        double n = f.n + g.n;
+        double w = f.n*g.n/n;
+        double d0 = g.mean[0] - f.mean[0];
+        double d1 = g.mean[1] - f.mean[1];
+        double de = g.eclipse - f.eclipse;
+
+        f.C[0] += g.C[0] + d0*d0*w;
+        f.C[1] += g.C[1] + d0*d1*w;
+        f.C[2] += g.C[2] + d1*d1*w;
+        f.mean[0] += d0*g.n/n;
+        f.mean[1] += d1*g.n/n;
+        f.eclipseM2 += g.eclipseM2 + de*de*w;
+        f.eclipse += de*g.n/n;
+        f.n = n;
+
+        f.eclipsemin = std::min(f.eclipsemin, g.eclipsemin);
+        f.eclipsemax = std::max(f.eclipsemax, g.eclipsemax);
+        for (i=0;i<ENSEMBLEBINS;i++)
+            f.hist[i] += g.hist[i];
+        for (i=0;i<2;i++)
+        {
+            f.ratemin[i] = std::min(f.ratemin[i], g.ratemin[i]);
+            f.ratemax[i] = std::max(f.ratemax[i], g.ratemax[i]);
+        }
+    }
+    return 1;
+}
+
+/*************************************************************************
+  Файл статистики - чтобы объединить ансамбли разных процессов:
+  признак, число моментов, шаг и строки EnsembleFrame. Запись - через
+  filetemp и filereplace.
+ *************************************************************************/
+int ensemblesave(const char * name, const Ensemble & e)
+{
+    std::string temp = filetemp(name);
+
+    std::ofstream out(temp.c_str(), std::ios::binary);
+    if (!out)
+        return 0;
+
+    int magic = ENSEMBLEMAGIC;
+    int frames = (int)e.frames.size();
+    out.write((const char *)&magic, sizeof(int));
+    out.write((const char *)&frames, sizeof(int));
+    out.write((const char *)&e.frame, sizeof(double));
+    out.write((const char *)e.frames.data(), frames*sizeof(EnsembleFrame));
+
+    return filereplace(out, temp, name);
+}
+
+int ensembleload(const char * name, Ensemble & e)
+{
+    std::ifstream in(name, std::ios::binary);
+    if (!in)
+        return 0;
+
+    int magic = 0, frames = 0;
+    in.read((char *)&magic, sizeof(int));
+    in.read((char *)&frames, sizeof(int));
+    in.read((char *)&e.frame, sizeof(double));
+    if (!in || magic != ENSEMBLEMAGIC || frames < 1
+        || (long long)frames*(long long)sizeof(EnsembleFrame) != fileremaining(in))
+        return 0;
+
+    e.frames.resize(frames);
+    in.read((char *)e.frames.data(), frames*sizeof(EnsembleFrame));
+    return in.good() ? 1 : 0;
+}
+
+/*************************************************************************
+  Таблица по моментам вывода: время, число прогонов, средние psi1 и
+  psi2, ковариация (11 12 22, несмещённая), время в тени (среднее,
+  отклонение, пределы), пределы dpsi1 и dpsi2, гистограмма доли
+  времени в тени.
+ *************************************************************************/
+void ensembleprint(std::ostream & out, const Ensemble & e)
+{
+    size_t k;
+    int i;
+    for (k=0;k<e.frames.size();k++)
+    {
+        const EnsembleFrame & f = e.frames[k];
+        if (f.n == 0.0)
+            continue;
+
+        double m = (f.n > 1.0) ? f.n - 1.0 : 1.0;
+        out<<e.frame*(k+1)<<" "<<f.n<<" "<<f.mean[0]<<" "<<f.mean[1]<<" "
+           <<f.C[0]/m<<" "<<f.C[1]/m<<" "<<f.C[2]/m<<" "
+           <<f.eclipse<<" "<<sqrt(f.eclipseM2/m)<<" "<<f.eclipsemin<<" "<<f.eclipsemax<<" "
+           <<f.ratemin[0]<<" "<<f.ratemax[0]<<" "<<f.ratemin[1]<<" "<<f.ratemax[1];
+        for (i=0;i<ENSEMBLEBINS;i++)
+            out<<" "<<f.hist[i];
+        out<<std::endl;
+    }
+}
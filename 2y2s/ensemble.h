@@ -0,0 +1,46 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+// Интервалов гистограммы доли времени в тени
+#define ENSEMBLEBINS 10
+
+/*************************************************************************
+  Статистика ансамбля прогонов на один момент вывода - без траекторий:
+  число прогонов, средние и ковариация углов панели (psi1, psi2),
+  накопленное время в тени (среднее, M2 Уэлфорда, пределы и гистограмма
+  доли от прошедшего времени) и пределы скоростей шарнира. Только
+  double, чтобы файл состояния читался одним блоком.
+ *************************************************************************/
+struct EnsembleFrame
+{
+    double n;
+    double mean[2];
+    double C[3];            // суммы произведений отклонений: 11, 12, 22
+    double eclipse;
+    double eclipseM2;
+    double eclipsemin;
+    double eclipsemax;
+    double hist[ENSEMBLEBINS];
+    double ratemin[2];
+    double ratemax[2];
+};
+
+// Память - frames.size() строк, от числа прогонов не зависит
+struct Ensemble
+{
+    double frame;           // с между моментами вывода
+    std::vector<EnsembleFrame> frames;
+};
+
+void ensembleinit(Ensemble & e, int frames, double frame);
+void ensembleadd(Ensemble & e, int k, const double * y, double eclipse);
+int ensemblemerge(Ensemble & a, const Ensemble & b);
+int ensemblesave(const char * name, const Ensemble & e);
+int ensembleload(const char * name, Ensemble & e);
+void ensembleprint(std::ostream & out, const Ensemble & e);
+
+#endif // ENSEMBLE_H
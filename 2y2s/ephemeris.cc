@@ -0,0 +1,90 @@
+#include "detector.h"
+#include "ephemeris.h"
+
+#include <algorithm>
+
+Chebyshev orbitchebyshev;
+
+/*************************************************************************
+  Эфемерида орбиты: движение центра масс (flag 0) интегрируется по
+  Рунге-Кутте от t0 до t1 с шагом не больше h, а положение и скорость
+  запоминаются только в узлах Чебышёва каждого сегмента длины len и
+  сразу сворачиваются в ncoef коэффициентов на координату. Между
+  узлами интегрирование продолжается с того же состояния, так что
+  сама орбита считается один раз. Ошибка положения оценивается по
+  точкам между узлами, через которые интегрирование тоже проходит.
+ *************************************************************************/
+void orbitfit(const double * y0, double t0, double t1, double len, int ncoef, double h)
+{
+    Chebyshev & ch = orbitchebyshev;
+    ch.dim = 6;
+    ch.ncoef = ncoef;
+    ch.t0 = t0;
+    ch.len = len;
+    ch.segments = (int)ceil((t1 - t0)/len);
+    if (ch.segments < 1)
+        ch.segments = 1;
+    ch.error = 0.0;
+    ch.c.assign(ch.segments*6*ncoef, 0.0);
+
+    // Точки сегмента по возрастанию времени: узлы (x_i) и проверочные
+    // (x = cos(pi*(i+1)/ncoef)) вперемешку, последняя - конец сегмента
+    std::vector<std::pair<double, int> > points(2*ncoef);
+    std::vector<double> values(ncoef*6);
+    std::vector<double> check(ncoef*6);
+    double approx[6];
+
+    double result[6];
+    int i, k, s;
+    for (k=0;k<6;k++)
+        result[k]=y0[k];
+
+    double t = t0;
+    for (s=0;s<ch.segments;s++)
+    {
+        double a = t0 + s*len;
+        for (i=0;i<ncoef;i++)
+        {
+            double x = cos(M_PI*(i + 0.5)/ncoef);
+            points[i] = std::make_pair(a + 0.5*len*(x + 1.0), i);
+            x = cos(M_PI*(i + 1.0)/ncoef);
+            points[ncoef + i] = std::make_pair(a + 0.5*len*(x + 1.0), ncoef + i);
+        }
+        std::sort(points.begin(), points.end());
+
+        for (i=0;i<2*ncoef;i++)
+        {
+            double tp = points[i].first;
+            int steps = (int)ceil((tp - t)/h);
+            if (steps > 0)
+                solvesystemrungekutta(6, t, tp, steps, result, 0);
+            t = tp;
+
+            int p = points[i].second;
+            double * out = (p < ncoef) ? &values[p*6] : &check[(p - ncoef)*6];
+            for (k=0;k<6;k++)
+                out[k]=result[k];
+        }
+        chebfitsegment(ch, s, values.data());
+
+        for (i=0;i<ncoef;i++)
+        {
+            double x = cos(M_PI*(i + 1.0)/ncoef);
+            chebeval(ch, a + 0.5*len*(x + 1.0), approx);
+            for (k=0;k<3;k++)
+            {
+                if (fabs(check[i*6 + k] - approx[k]) > ch.error)
+                    ch.error = fabs(check[i*6 + k] - approx[k]);
+            }
+        }
+    }
+}
+
+/*************************************************************************
+  Состояние орбиты (положение и скорость) в любой момент t: сегмент
+  находится делением, значение - схемой Кленшоу, без интегрирования.
+ *************************************************************************/
+void orbitat(double t, double * result)
+{
+    chebeval(orbitchebyshev, t, result);
+}
@@ -0,0 +1,11 @@
+#ifndef EPHEMERIS_H
+#define EPHEMERIS_H
+
+#include "chebyshev.h"
+
+extern Chebyshev orbitchebyshev;
+
+void orbitfit(const double * y0, double t0, double t1, double len, int ncoef, double h);
+void orbitat(double t, double * result);
+
+#endif // EPHEMERIS_H
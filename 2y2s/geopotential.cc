@@ -0,0 +1,263 @@
+#include "detector.h"
+#include "geopotential.h"
+#include "sun.h"
+
+#include <vector>
+#include <chrono>
+
+// Степень разложения поля (0 - точечная масса) и признак учёта
+// гравитационного момента в угловом движении
+int geodegree = 0;
+int gravitygradient = 0;
+
+// Положение спутника (инерциальное), для которого считается
+// гравитационный момент текущего кадра. У каждого потока своё: потоки
+// Parareal считают разные кадры одновременно
+thread_local double gravityposition[3];
+
+#define GEON (GEOMAXDEGREE + 2)
+
+// Наибольший порядок m с ненулевыми коэффициентами в таблице: рекурсия
+// и сумма дальше него не идут
+#define GEOMAXORDER 4
+
+/*************************************************************************
+  Ненормированные коэффициенты C_nm, S_nm модели JGM-3 (Montenbruck,
+  Gill, "Satellite Orbits", табл. 3.2). Тессеральные гармоники заданы до
+  4-й степени, зональные (C_n0 = -J_n) - до 8-й.
+ *************************************************************************/
+static const double geoC[GEOMAXDEGREE + 1][GEOMAXDEGREE + 1] =
+{
+    { 1.0 },
+    { 0.0, 0.0 },
+    {-1.08262668355e-3, -2.414e-10, 1.57446037456e-6 },
+    { 2.53243534e-6, 2.19263852e-6, 3.08989206e-7, 1.00548778e-7 },
+    { 1.61933120e-6, -5.08799360e-7, 7.84175859e-8, 5.92099402e-8, -3.98407411e-9 },
+    { 2.27716611e-7 },
+    {-5.39648490e-7 },
+    { 3.51368442e-7 },
+    { 2.02518715e-7 }
+};
+
+static const double geoS[GEOMAXDEGREE + 1][GEOMAXDEGREE + 1] =
+{
+    { 0.0 },
+    { 0.0, 0.0 },
+    { 0.0, 1.543e-9, -9.03803806639e-7 },
+    { 0.0, 2.68424890e-7, -2.11437612e-7, 1.97222559e-7 },
+    { 0.0, -4.49144872e-7, 1.48177868e-7, -1.20077667e-8, 6.52571425e-9 }
+};
+
+// Постоянные множители рекурсии и суммы ускорения: зависят только от
+// n и m, так что считаются один раз в geopotentialinit
+static double geok1[GEON][GEON];
+static double geok2[GEON][GEON];
+static double geofac[GEON][GEON];
+
+// Рабочие массивы рекурсии V_nm, W_nm: статические, без выделения
+// памяти в правой части
+static double geoV[GEON][GEON];
+static double geoW[GEON][GEON];
+
+// Поворот Земли для последнего момента: этапы Рунге-Кутты и соседние
+// шаги приходятся на одни и те же моменты времени
+static double geotime = -1e300;
+static double geocos = 1.0;
+static double geosin = 0.0;
+
+void geopotentialinit(int degree)
+{
+    if (degree > GEOMAXDEGREE)
+        degree = GEOMAXDEGREE;
+    if (degree < 0)
+        degree = 0;
+    geodegree = degree;
+
+    int n, m;
+    for (n=0;n<GEON;n++)
+    {
+        for (m=0;m<GEON;m++)
+        {
+            geok1[n][m] = (n > m) ? (2.0*n - 1.0)/(n - m) : 0.0;
+            geok2[n][m] = (n > m) ? (n + m - 1.0)/(n - m) : 0.0;
+            geofac[n][m] = 0.5*(n - m + 1.0)*(n - m + 2.0);
+        }
+    }
+}
+
+/*************************************************************************
+  Звёздное время по Гринвичу (рад) через t секунд после epochjd -
+  поворот земной системы относительно инерциальной.
+ *************************************************************************/
+double greenwich(double t)
+{
+    double d = epochjd - 2451545.0 + t/86400.0;
+    double theta = fmod(280.46061837 + 360.98564736629*d, 360.0);
+
+    return theta*M_PI/180.0;
+}
+
+/*************************************************************************
+  Ускорение от гравитационного поля степени geodegree в инерциальной
+  системе. Рекурсия Каннингема для V_nm, W_nm (сферические функции,
+  делённые на r^(n+1), сразу в декартовых координатах - без синусов и
+  косинусов широты и долготы); затем ускорение собирается по
+  Montenbruck, Gill, 3.2.4. Степень 0 - точечная масса, тот же результат,
+  что и в прежней правой части.
+ *************************************************************************/
+void geoacceleration(double t, const double * r, double * a)
+{
+    double rsqr = r[0]*r[0] + r[1]*r[1] + r[2]*r[2];
+
+    if (geodegree < 2)
+    {
+        double k = -M/(rsqr*sqrt(rsqr));
+        a[0] = k*r[0];
+        a[1] = k*r[1];
+        a[2] = k*r[2];
+        return;
+    }
+
+    // В земную систему: поворот вокруг оси z на звёздное время
+    if (t != geotime)
+    {
+        double theta = greenwich(t);
+        geocos = cos(theta);
+        geosin = sin(theta);
+        geotime = t;
+    }
+    double ct = geocos;
+    double st = geosin;
+    double xe = ct*r[0] + st*r[1];
+    double ye = -st*r[0] + ct*r[1];
+
+    double rho = GEORADIUS*GEORADIUS/rsqr;
+    double x0 = GEORADIUS*xe/rsqr;
+    double y0 = GEORADIUS*ye/rsqr;
+    double z0 = GEORADIUS*r[2]/rsqr;
+
+    int nmax = geodegree;
+    int mmax = (nmax < GEOMAXORDER) ? nmax : GEOMAXORDER;
+    int n, m;
+
+    geoV[0][0] = GEORADIUS/sqrt(rsqr);
+    geoW[0][0] = 0.0;
+    geoV[1][0] = z0*geoV[0][0];
+    geoW[1][0] = 0.0;
+    for (n=2;n<=nmax+1;n++)
+    {
+        geoV[n][0] = geok1[n][0]*z0*geoV[n-1][0] - geok2[n][0]*rho*geoV[n-2][0];
+        geoW[n][0] = 0.0;
+    }
+
+    for (m=1;m<=mmax+1;m++)
+    {
+        geoV[m][m] = (2.0*m - 1.0)*(x0*geoV[m-1][m-1] - y0*geoW[m-1][m-1]);
+        geoW[m][m] = (2.0*m - 1.0)*(x0*geoW[m-1][m-1] + y0*geoV[m-1][m-1]);
+        if (m <= nmax)
+        {
+            geoV[m+1][m] = (2.0*m + 1.0)*z0*geoV[m][m];
+            geoW[m+1][m] = (2.0*m + 1.0)*z0*geoW[m][m];
+        }
+        for (n=m+2;n<=nmax+1;n++)
+        {
+            geoV[n][m] = geok1[n][m]*z0*geoV[n-1][m] - geok2[n][m]*rho*geoV[n-2][m];
+            geoW[n][m] = geok1[n][m]*z0*geoW[n-1][m] - geok2[n][m]*rho*geoW[n-2][m];
+        }
+    }
+
+    double ax = 0.0;
+    double ay = 0.0;
+    double az = 0.0;
+    for (n=0;n<=nmax;n++)
+    {
+        double C = geoC[n][0];
+        ax -= C*geoV[n+1][1];
+        ay -= C*geoW[n+1][1];
+        az -= (n + 1.0)*C*geoV[n+1][0];
+
+        int mn = (n < mmax) ? n : mmax;
+        for (m=1;m<=mn;m++)
+        {
+            C = geoC[n][m];
+            double S = geoS[n][m];
+            double fac = geofac[n][m];
+            ax += 0.5*(-C*geoV[n+1][m+1] - S*geoW[n+1][m+1])
+                + fac*(C*geoV[n+1][m-1] + S*geoW[n+1][m-1]);
+            ay += 0.5*(-C*geoW[n+1][m+1] + S*geoV[n+1][m+1])
+                + fac*(-C*geoW[n+1][m-1] + S*geoV[n+1][m-1]);
+            az += (n - m + 1.0)*(-C*geoV[n+1][m] - S*geoW[n+1][m]);
+        }
+    }
+
+    double k = M/(GEORADIUS*GEORADIUS);
+    ax *= k;
+    ay *= k;
+    az *= k;
+
+    // Обратно в инерциальную систему
+    a[0] = ct*ax - st*ay;
+    a[1] = st*ax + ct*ay;
+    a[2] = az;
+}
+
+/*************************************************************************
+  Время правой части орбиты: точечная масса и поле степени 2..8 на
+  одном наборе случайных положений.
+ *************************************************************************/
+void geopotentialbenchmark()
+{
+    const int count = 1000;
+    const int repeat = 1000;
+
+    std::vector<double> rs(3*count);
+
+    srand(1);
+    int i, k;
+    for (i=0;i<count;i++)
+    {
+        double z = 2.0*rand()/(double)RAND_MAX - 1.0;
+        double a = 2.0*M_PI*rand()/(double)RAND_MAX;
+        double h = 6600000.0 + 30000000.0*rand()/(double)RAND_MAX;
+        rs[3*i] = h*sqrt(1 - z*z)*cos(a);
+        rs[3*i + 1] = h*sqrt(1 - z*z)*sin(a);
+        rs[3*i + 2] = h*z;
+    }
+
+    int saved = geodegree;
+    double acc[3];
+    double sum = 0.0;
+    double nspoint = 0.0;
+
+    int degree;
+    for (degree=0;degree<=GEOMAXDEGREE;degree++)
+    {
+        if (degree == 1)
+            continue;
+        geopotentialinit(degree);
+
+        auto t0 = std::chrono::steady_clock::now();
+        for (k=0;k<repeat;k++)
+        {
+            for (i=0;i<count;i++)
+            {
+                geoacceleration(k, &rs[3*i], acc);
+                sum += acc[0];
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+
+        double ns = std::chrono::duration<double, std::nano>(t1 - t0).count()/count/repeat;
+        if (degree == 0)
+            nspoint = ns;
+
+        std::cout<<"GEOPOTENTIAL DEGREE "<<degree<<" "<<ns<<" ns ("
+                 <<ns/nspoint<<" x POINT MASS)"<<std::endl;
+    }
+
+    geopotentialinit(saved);
+
+    // Чтобы сумма не была выброшена оптимизатором
+    if (sum == 1.0)
+        std::cout<<sum<<std::endl;
+}
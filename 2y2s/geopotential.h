@@ -0,0 +1,18 @@
+#ifndef GEOPOTENTIAL_H
+#define GEOPOTENTIAL_H
+
+// Наибольшая степень разложения и экваториальный радиус модели (JGM-3)
+#define GEOMAXDEGREE 8
+#define GEORADIUS 6378136.3
+#define EARTHROTATION 7.2921158553e-5
+
+extern int geodegree;
+extern int gravitygradient;
+extern thread_local double gravityposition[3];
+
+void geopotentialinit(int degree);
+void geoacceleration(double t, const double * r, double * a);
+double greenwich(double t);
+void geopotentialbenchmark();
+
+#endif // GEOPOTENTIAL_H
@@ -0,0 +1,303 @@
+#include "detector.h"
+#include "golden.h"
+#include "adaptive.h"
+#include "eclipse.h"
+#include "modal.h"
+#include "binfile.h"
+
+#include <string.h>
+#include <vector>
+#include <string>
+#include <chrono>
+
+// Признак файла эталона ("GLD1")
+#define GOLDENMAGIC 0x31444c47
+
+#define GOLDENFRAMES 150
+
+/*************************************************************************
+  Канонические сценарии: начальное состояние и параметры - из main()
+  (I1, I2, a1, a2_, c, sunvec, y, result), 150 кадров по 10 с.
+  flag - модель углового движения, как в ff: 1 - панель на шарнире
+  (прогон main() без ключей), 2 - застопоренная панель, 4 - панель с
+  упругими формами.
+ *************************************************************************/
+struct GoldenScenario
+{
+    const char * name;
+    int flag;
+    int modes;
+};
+
+static const GoldenScenario goldenscenarios[] = {
+    {"main", 1, 0},
+    {"rigid", 2, 0},
+    {"modal", 4, 3},
+};
+
+#define GOLDENSCENARIOS ((int)(sizeof(goldenscenarios)/sizeof(goldenscenarios[0])))
+
+/*************************************************************************
+  Столбцы строки траектории: доля солнечного диска, орбита (м, м/с),
+  затем вектор состояния y. Значение совпадает с эталоном x0, если
+
+      |x - x0| <= abstol + reltol*|x0|
+
+  Допуски - на уровне округления за 1500 с (другой компилятор,
+  -ffp-contract, порядок суммирования), но много меньше любой ошибки
+  интегрирования.
+ *************************************************************************/
+struct GoldenColumn
+{
+    const char * name;
+    double abstol;
+    double reltol;
+};
+
+static const GoldenColumn goldencolumns[18] = {
+    {"frac", 1e-9, 0.0},
+    {"x", 1e-6, 1e-12}, {"y", 1e-6, 1e-12}, {"z", 1e-6, 1e-12},
+    {"vx", 1e-9, 1e-12}, {"vy", 1e-9, 1e-12}, {"vz", 1e-9, 1e-12},
+    {"w1", 1e-13, 1e-8}, {"w2", 1e-13, 1e-8}, {"w3", 1e-13, 1e-8},
+    {"q1", 1e-10, 0.0}, {"q2", 1e-10, 0.0}, {"q3", 1e-10, 0.0}, {"q4", 1e-10, 0.0},
+    {"psi1", 1e-10, 1e-8}, {"psi2", 1e-10, 1e-8},
+    {"dpsi1", 1e-13, 1e-8}, {"dpsi2", 1e-13, 1e-8},
+};
+
+static const GoldenColumn goldenmodal[2*MAXMODES] = {
+    {"eta1", 1e-13, 1e-8}, {"eta2", 1e-13, 1e-8}, {"eta3", 1e-13, 1e-8}, {"eta4", 1e-13, 1e-8},
+    {"deta1", 1e-13, 1e-8}, {"deta2", 1e-13, 1e-8}, {"deta3", 1e-13, 1e-8}, {"deta4", 1e-13, 1e-8},
+};
+
+// Столбец k сценария с modes упругими формами
+static const GoldenColumn & goldencolumn(int k, int modes)
+{
+    if (k < 18)
+        return goldencolumns[k];
+    k -= 18;
+    return (k < modes) ? goldenmodal[k] : goldenmodal[MAXMODES + k - modes];
+}
+
+/*************************************************************************
+  Прогон сценария тем же порядком вызовов, что и кадры main(): сначала
+  орбита на все кадры и освещённость одним вызовом, потом угловое
+  движение по кадрам. traj - GOLDENFRAMES строк по 7 + n чисел.
+ *************************************************************************/
+static int goldenrun(const GoldenScenario & sc, double * y0, double * result0, std::vector<double> & traj)
+{
+    int n = 11 + 2*sc.modes;
+    int cols = 7 + n;
+    int savedmodes = nmodes;
+    modalinit(sc.modes);
+
+    double y[11+2*MAXMODES];
+    double orb[6];
+    int i, j;
+    for (i=0;i<11;i++)
+        y[i]=y0[i];
+    for (i=11;i<11+2*MAXMODES;i++)
+        y[i]=0.0;
+    for (i=0;i<6;i++)
+        orb[i]=result0[i];
+    if (sc.flag == 2)
+        lockpanel(y);
+
+    double orbit[GOLDENFRAMES][6];
+    double ox[GOLDENFRAMES], oy[GOLDENFRAMES], oz[GOLDENFRAMES];
+    double sx[GOLDENFRAMES], sy[GOLDENFRAMES], sz[GOLDENFRAMES];
+    double frac[GOLDENFRAMES];
+    for (j=0;j<GOLDENFRAMES;j++)
+    {
+        solvesystemrungekutta(6,10*j,10*(j+1),10,orb, 0);
+        for (i=0;i<6;i++)
+            orbit[j][i]=orb[i];
+        ox[j]=orb[0];
+        oy[j]=orb[1];
+        oz[j]=orb[2];
+        sx[j]=sunvec[0];
+        sy[j]=sunvec[1];
+        sz[j]=sunvec[2];
+    }
+    illuminationbatch(GOLDENFRAMES, ox, oy, oz, sx, sy, sz, frac);
+
+    traj.resize(GOLDENFRAMES*cols);
+    for (j=0;j<GOLDENFRAMES;j++)
+    {
+        if (sc.flag == 4)
+            solvesystemrungekutta(n,0,10,modalsteps(10),y, 4);
+        else
+            solvesystemrungekutta(11,0,10,10,y, sc.flag);
+
+        double * row = &traj[j*cols];
+        row[0]=frac[j];
+        for (i=0;i<6;i++)
+            row[1+i]=orbit[j][i];
+        for (i=0;i<n;i++)
+            row[7+i]=y[i];
+    }
+
+    modalinit(savedmodes);
+    return cols;
+}
+
+static std::string goldenpath(const char * dir, const GoldenScenario & sc)
+{
+    return std::string(dir) + "/" + sc.name + ".bin";
+}
+
+static int goldensave(const std::string & name, int rows, int cols, const std::vector<double> & traj)
+{
+    std::string temp = filetemp(name);
+    std::ofstream out(temp.c_str(), std::ios::binary);
+    if (!out)
+        return 0;
+
+    int magic = GOLDENMAGIC;
+    out.write((const char *)&magic, sizeof(int));
+    out.write((const char *)&rows, sizeof(int));
+    out.write((const char *)&cols, sizeof(int));
+    out.write((const char *)traj.data(), traj.size()*sizeof(double));
+
+    return filereplace(out, temp, name);
+}
+
+static int goldenload(const std::string & name, int & rows, int & cols, std::vector<double> & traj)
+{
+    std::ifstream in(name.c_str(), std::ios::binary);
+    if (!in)
+        return 0;
+
+    int magic = 0;
+    in.read((char *)&magic, sizeof(int));
+    in.read((char *)&rows, sizeof(int));
+    in.read((char *)&cols, sizeof(int));
+    if (!in || magic != GOLDENMAGIC || rows < 1 || cols < 1
+        || (long long)rows*cols*(long long)sizeof(double) != fileremaining(in))
+        return 0;
+
+    traj.resize(rows*cols);
+    in.read((char *)traj.data(), traj.size()*sizeof(double));
+
+    return in.good() ? 1 : 0;
+}
+
+/*************************************************************************
+  Запись эталонов всех сценариев в каталог dir (он должен существовать).
+  Возвращает число сценариев, которые не удалось записать.
+ *************************************************************************/
+int goldenrecord(double * y, double * result, const char * dir)
+{
+    int failed = 0;
+    int s;
+    for (s=0;s<GOLDENSCENARIOS;s++)
+    {
+        const GoldenScenario & sc = goldenscenarios[s];
+        std::vector<double> traj;
+        int cols = goldenrun(sc, y, result, traj);
+        std::string name = goldenpath(dir, sc);
+        if (goldensave(name, GOLDENFRAMES, cols, traj))
+            std::cout<<"GOLDEN "<<sc.name<<" RECORDED "<<name<<std::endl;
+        else
+        {
+            std::cout<<"GOLDEN "<<sc.name<<" CANNOT WRITE "<<name<<std::endl;
+            failed++;
+        }
+    }
+    return failed;
+}
+
+/*************************************************************************
+  Сравнение с эталоном. Сначала побайтно (обычный случай - та же сборка,
+  расхождений нет), иначе по строкам с допусками столбцов до первого
+  расхождения: о нём печатаются кадр, момент, столбец, эталон и
+  значение. Для прошедших сценариев - наибольшая доля допуска.
+ *************************************************************************/
+static int goldencompare(const GoldenScenario & sc, const std::vector<double> & golden,
+                         const std::vector<double> & traj, int cols)
+{
+    if (memcmp(golden.data(), traj.data(), traj.size()*sizeof(double)) == 0)
+    {
+        std::cout<<"GOLDEN "<<sc.name<<" PASS BIT-IDENTICAL"<<std::endl;
+        return 1;
+    }
+
+    double worst = 0.0;
+    int worstrow = 0, worstcol = 0;
+    int j, k;
+    for (j=0;j<GOLDENFRAMES;j++)
+    {
+        const double * g = &golden[j*cols];
+        const double * a = &traj[j*cols];
+        for (k=0;k<cols;k++)
+        {
+            const GoldenColumn & col = goldencolumn(k, sc.modes);
+            double diff = fabs(a[k] - g[k]);
+            double allowed = col.abstol + col.reltol*fabs(g[k]);
+
+            // NaN в прогоне - тоже расхождение
+            if (!(diff <= allowed))
+            {
+                std::streamsize precision = std::cout.precision(17);
+                std::cout<<"GOLDEN "<<sc.name<<" FAIL FRAME "<<j<<" T "<<10*(j+1)
+                         <<" COLUMN "<<col.name<<" GOLDEN "<<g[k]<<" ACTUAL "<<a[k];
+                std::cout.precision(precision);
+                std::cout<<" DIFF "<<diff<<" ALLOWED "<<allowed<<std::endl;
+                return 0;
+            }
+            if (diff > worst*allowed)
+            {
+                worst = diff/allowed;
+                worstrow = j;
+                worstcol = k;
+            }
+        }
+    }
+
+    std::cout<<"GOLDEN "<<sc.name<<" PASS WORST "<<worst<<" OF TOLERANCE ("
+             <<goldencolumn(worstcol, sc.modes).name<<", FRAME "<<worstrow<<")"<<std::endl;
+    return 1;
+}
+
+/*************************************************************************
+  Проверка всех сценариев по эталонам из dir. Возвращает число
+  непрошедших сценариев (код завершения программы - 0, если всё
+  совпало).
+ *************************************************************************/
+int goldencheck(double * y, double * result, const char * dir)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    int failed = 0;
+    int s;
+    for (s=0;s<GOLDENSCENARIOS;s++)
+    {
+        const GoldenScenario & sc = goldenscenarios[s];
+        std::string name = goldenpath(dir, sc);
+
+        std::vector<double> golden;
+        int rows = 0, cols = 0;
+        if (!goldenload(name, rows, cols, golden))
+        {
+            std::cout<<"GOLDEN "<<sc.name<<" NO REFERENCE "<<name<<" (-goldenrecord)"<<std::endl;
+            failed++;
+            continue;
+        }
+
+        std::vector<double> traj;
+        int n = goldenrun(sc, y, result, traj);
+        if (rows != GOLDENFRAMES || cols != n)
+        {
+            std::cout<<"GOLDEN "<<sc.name<<" FAIL SHAPE "<<rows<<"x"<<cols
+                     <<" EXPECTED "<<GOLDENFRAMES<<"x"<<n<<std::endl;
+            failed++;
+            continue;
+        }
+
+        if (!goldencompare(sc, golden, traj, cols))
+            failed++;
+    }
+
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout<<"GOLDEN "<<GOLDENSCENARIOS - failed<<" OF "<<GOLDENSCENARIOS<<" PASSED IN "
+             <<std::chrono::duration<double>(t1 - t0).count()<<" s"<<std::endl;
+    return failed;
+}
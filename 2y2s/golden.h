@@ -0,0 +1,10 @@
+#ifndef GOLDEN_H
+#define GOLDEN_H
+
+// Каталог эталонных траекторий: <каталог>/<сценарий>.bin
+#define GOLDENDIR "golden"
+
+int goldenrecord(double * y, double * result, const char * dir);
+int goldencheck(double * y, double * result, const char * dir);
+
+#endif // GOLDEN_H
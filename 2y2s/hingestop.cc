@@ -0,0 +1,323 @@
+#include "detector.h"
+#include "hingestop.h"
+#include "conservation.h"
+#include "scenario.h"
+
+#include <vector>
+
+// Упоры шарнира по углам y[7], y[8]; по умолчанию упоров нет
+double psimin[2] = {-1e9, -1e9};
+
+double psimax[2] = {1e9, 1e9};
+
+// Коэффициент восстановления при ударе
+double restitution = 0.5;
+
+// Зазор, меньше которого панель считается лежащей на поверхности (рад
+// для упоров шарнира, м для касания корпуса)
+double contacttol = 1e-9;
+
+// Углы панели на дальнем от шарнира краю (в тех же координатах, что и
+// вершины для Ansi), по которым проверяется касание корпуса
+mtl::dense_vector <double> contactpoints[MAXCONTACTS];
+
+int ncontactpoints = 0;
+
+int impacts = 0;
+
+// Шагов, после которых касание держалось и панель возвращалась на
+// поверхность (settle)
+int contacts = 0;
+
+// Упоры и точки касания сценария (ключи psimin, psimax, contacts,
+// contact) - для -stops
+void stopsinit(const Scenario & sc)
+{
+    int i, k;
+    for (i=0;i<2;i++)
+    {
+        psimin[i] = sc.psimin[i];
+        psimax[i] = sc.psimax[i];
+    }
+
+    ncontactpoints = 0;
+    for (k=0;k<sc.contacts;k++)
+    {
+        mtl::dense_vector <double> d(3);
+        for (i=0;i<3;i++)
+            d(i) = sc.contact[k][i];
+        addcontactpoint(d);
+    }
+}
+
+void addcontactpoint(mtl::dense_vector <double> ai)
+{
+    if (ncontactpoints < MAXCONTACTS)
+        contactpoints[ncontactpoints++] = ai;
+}
+
+int ngaps()
+{
+    return 4 + ncontactpoints;
+}
+
+/*************************************************************************
+  Зазоры. k=0..3 - расстояние до упоров шарнира:
+  y[7]-psimin[0], psimax[0]-y[7], y[8]-psimin[1], psimax[1]-y[8].
+  k=4.. - высота угла панели над гранью корпуса, на которой стоит шарнир:
+  проекция (corner - a1) на нормаль грани a1/|a1|. Шарнир лежит на грани,
+  так что отрицательная высота дальнего края означает, что панель вошла
+  в корпус.
+ *************************************************************************/
+double gap(double * y, int k)
+{
+    using namespace mtl;
+
+    switch (k)
+    {
+        case 0: return y[7]-psimin[0];
+        case 1: return psimax[0]-y[7];
+        case 2: return y[8]-psimin[1];
+        case 3: return psimax[1]-y[8];
+        default : break;
+    }
+
+    dense_vector <double> rho(3);
+    rho = corner(contactpoints[k-4], y) - a1;
+
+    return dot(rho, a1)/two_norm(a1);
+}
+
+double mingap(double * y, int * k)
+{
+    double g = gap(y, 0);
+    *k = 0;
+
+    int i;
+    for (i=1;i<ngaps();i++)
+    {
+        double t = gap(y, i);
+        if (t < g)
+        {
+            g = t;
+            *k = i;
+        }
+    }
+
+    return g;
+}
+
+/*************************************************************************
+  Скорость изменения зазора k как линейная функция обобщённых скоростей
+  (omega, y[9], y[10]): gap' = J*u. От omega зазоры не зависят.
+  Для касания: gap' = ((e1*y[9] + B1^T e3*y[10]) x rho, n).
+ *************************************************************************/
+mtl::dense_vector <double> gapjacobian(double * y, int k)
+{
+    using namespace mtl;
+
+    dense_vector <double> J(5);
+    J = 0.0;
+
+    switch (k)
+    {
+        case 0: J(3)=1.0; return J;
+        case 1: J(3)=-1.0; return J;
+        case 2: J(4)=1.0; return J;
+        case 3: J(4)=-1.0; return J;
+        default : break;
+    }
+
+    dense_vector <double> rho(3);
+    rho = corner(contactpoints[k-4], y) - a1;
+
+    dense_vector <double> n(3);
+    n = a1/two_norm(a1);
+
+    J(3)=dot(cross(e1, rho), n);
+    J(4)=dot(cross(dense_vector <double>(trans(B1(y))*e3(y)), rho), n);
+
+    return J;
+}
+
+// Скорость изменения зазора k
+static double gaprate(double * y, int k)
+{
+    mtl::dense_vector <double> J(5);
+    J = gapjacobian(y, k);
+    return J(0)*y[0] + J(1)*y[1] + J(2)*y[2] + J(3)*y[9] + J(4)*y[10];
+}
+
+/*************************************************************************
+  Импульс по зазору k. Импульс - внутренний (между панелью и корпусом),
+  поэтому в обобщённых координатах он равен J^T*lambda, а кинетический
+  момент системы не меняется. lambda выбирается так, чтобы скорость
+  сближения сменила знак и уменьшилась в e раз:
+
+      S*du = J^T*lambda,  J*(u+du) = -e*J*u
+
+  Возвращает 0, если панель и корпус не сближаются.
+ *************************************************************************/
+static int impulse(double * y, int k, double e)
+{
+    using namespace mtl;
+
+    dense_vector <double> u(5);
+    int i;
+    for (i=0;i<3;i++)
+        u(i)=y[i];
+    u(3)=y[9];
+    u(4)=y[10];
+
+    dense_vector <double> J(5);
+    J = gapjacobian(y, k);
+
+    double Ju = dot(J, u);
+    if (Ju >= 0)
+        return 0;
+
+    dense_vector <double> SJ(5);
+    SJ = mat::inv(S(y))*J;
+
+    double lambda = -(1.0 + e)*Ju/dot(J, SJ);
+
+    u += SJ*lambda;
+
+    for (i=0;i<3;i++)
+        y[i]=u(i);
+    y[9]=u(3);
+    y[10]=u(4);
+
+    return 1;
+}
+
+// Удар с коэффициентом восстановления restitution
+void impact(double * y, int k)
+{
+    if (impulse(y, k, restitution))
+        impacts++;
+}
+
+/*************************************************************************
+  Касание, которое держится (удар не разводит панель с корпусом): углы
+  панели сдвигаются по градиенту зазора k до gap = 0 (Ньютон по y[7],
+  y[8], для упоров шарнира - точно за одну итерацию), скорость сближения
+  гасится неупругим импульсом. Возвращает 1, если состояние поправлено.
+ *************************************************************************/
+int settle(double * y)
+{
+    using namespace mtl;
+
+    int k;
+    int it;
+    int moved = 0;
+    for (it=0;it<10;it++)
+    {
+        double g = mingap(y, &k);
+        if (g >= 0)
+            break;
+
+        dense_vector <double> J(5);
+        J = gapjacobian(y, k);
+        double jj = J(3)*J(3) + J(4)*J(4);
+        if (jj == 0)
+            break;
+
+        y[7] -= g*J(3)/jj;
+        y[8] -= g*J(4)/jj;
+        impulse(y, k, 0.0);
+        moved = 1;
+    }
+
+    if (moved)
+        contacts++;
+    return moved;
+}
+
+/*************************************************************************
+  Рунге-Кутта с упорами (flag=1). Шаг, на котором какой-то зазор стал
+  отрицательным, повторяется из начальной точки с долей шага, найденной
+  делением пополам; в точке касания применяется удар, и остаток шага
+  доделывается тем же способом. Остальные шаги не меняются. Если касание
+  держится (удар в самом начале остатка или удары идут чередой), остаток
+  шага проходится без событий, и состояние возвращается на поверхность
+  через settle. Следующие шаги, начатые на поверхности (зазор не больше
+  contacttol) без скорости отхода, делаются так же, пока панель сама не
+  отойдёт.
+ *************************************************************************/
+void solvesystemstops(int n, double x, double x1, int steps, double * y, int flag)
+{
+    double h = (x1-x)/steps;
+    std::vector<double> y0(n);
+    std::vector<double> yt(n);
+
+    int i, j, k;
+    for(i = 0; i < steps; i++)
+    {
+        double t = x+i*h;
+        double rest = h;
+        int events = 0;
+
+        while (rest > 0)
+        {
+            for (j=0;j<n;j++)
+                y0[j]=y[j];
+
+            // Панель лежит на поверхности и не отходит от неё - касание
+            // держится, остаток шага без поиска событий
+            if (mingap(y, &k) <= contacttol && gaprate(y, k) <= 0)
+            {
+                step(n, t, rest, y, flag);
+                settle(y);
+                break;
+            }
+
+            step(n, t, rest, y, flag);
+
+            if (mingap(y, &k) >= 0)
+                break;
+
+            // Касание внутри шага: ищем его момент
+            double lo = 0.0;
+            double hi = rest;
+            while (hi - lo > 1e-9 * h)
+            {
+                double mid = 0.5*(lo + hi);
+                for (j=0;j<n;j++)
+                    yt[j]=y0[j];
+                step(n, t, mid, &yt[0], flag);
+
+                if (mingap(&yt[0], &k) >= 0)
+                    lo = mid;
+                else
+                    hi = mid;
+            }
+
+            for (j=0;j<n;j++)
+                y[j]=y0[j];
+            if (lo > 0)
+                step(n, t, lo, y, flag);
+
+            mingap(y, &k);
+            impact(y, k);
+
+            t += lo;
+            rest -= lo;
+
+            // Удар не разводит панель с корпусом (скорость сближения
+            // уже нулевая) или удары идут чередой - остаток шага без
+            // событий, затем панель возвращается на поверхность
+            events++;
+            if (lo == 0 || events > 100)
+            {
+                step(n, t, rest, y, flag);
+                settle(y);
+                break;
+            }
+        }
+
+        // Удары с коэффициентом восстановления меньше 1 уносят энергию
+        if (monitor)
+            monitorstep(y, flag);
+    }
+}
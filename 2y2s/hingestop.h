@@ -0,0 +1,36 @@
+#ifndef HINGESTOP_H
+#define HINGESTOP_H
+
+#include <boost/numeric/mtl/mtl.hpp>
+
+// Наибольшее число точек касания корпуса
+#define MAXCONTACTS 4
+
+extern double psimin[2];
+
+extern double psimax[2];
+
+extern double restitution;
+
+extern double contacttol;
+
+extern mtl::dense_vector <double> contactpoints[MAXCONTACTS];
+
+extern int ncontactpoints;
+
+extern int impacts;
+
+extern int contacts;
+
+struct Scenario;
+void stopsinit(const Scenario & sc);
+void addcontactpoint(mtl::dense_vector <double> ai);
+int ngaps();
+double gap(double * y, int k);
+double mingap(double * y, int * k);
+mtl::dense_vector <double> gapjacobian(double * y, int k);
+void impact(double * y, int k);
+int settle(double * y);
+void solvesystemstops(int n, double x, double x1, int steps, double * y, int flag);
+
+#endif // HINGESTOP_H
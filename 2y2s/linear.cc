@@ -0,0 +1,164 @@
+#include "detector.h"
+#include "linear.h"
+
+// Отклонение состояния от точки линеаризации (наибольшее по компонентам
+// y), после которого точка переносится
+double lineartol = 0.05;
+
+// Наибольшее расхождение кадра линейной модели с нелинейной в точке
+// линеаризации, при котором кадры считаются линейной моделью
+double linearerror = 1e-6;
+
+/*************************************************************************
+  Линеаризация системы y'=ff(y) в точке ys (n=11 для flag=1).
+
+  Возвращает расширенную матрицу размера (n+1)x(n+1):
+
+      | A  f(ys) |
+      | 0    0   |
+
+  где A - матрица Якоби, посчитанная центральными разностями. Свободный
+  столбец позволяет линеаризовать и не в точке равновесия.
+ *************************************************************************/
+mtl::dense2D<double> linearize(double * ys, int flag)
+{
+    using namespace mtl;
+
+    int n = (flag == 1) ? 11 : 6;
+
+    dense2D<double> A(n+1, n+1);
+    A = 0.0;
+
+    double yp[11], ym[11], fp[11], fm[11];
+
+    int i, j;
+
+    ff(0, ys, fp, flag);
+    for (i=0;i<n;i++)
+        A(i,n)=fp[i];
+
+    for (j=0;j<n;j++)
+    {
+        for (i=0;i<n;i++)
+        {
+            yp[i]=ys[i];
+            ym[i]=ys[i];
+        }
+
+        double h = 1e-6 * (1.0 + fabs(ys[j]));
+        yp[j] += h;
+        ym[j] -= h;
+
+        ff(0, yp, fp, flag);
+        ff(0, ym, fm, flag);
+
+        for (i=0;i<n;i++)
+            A(i,j)=(fp[i]-fm[i])/(2.0*h);
+    }
+
+    return A;
+}
+
+/*************************************************************************
+  Матричная экспонента: масштабирование и возведение в квадрат,
+  ряд Тейлора до 12-го члена для A/2^s с нормой не больше 0.5.
+ *************************************************************************/
+mtl::dense2D<double> expm(mtl::dense2D<double> A)
+{
+    using namespace mtl;
+
+    int n = num_rows(A);
+
+    double norm = 0.0;
+    int i, j;
+    for (i=0;i<n;i++)
+    {
+        double row = 0.0;
+        for (j=0;j<n;j++)
+            row += fabs(A(i,j));
+        if (row > norm)
+            norm = row;
+    }
+
+    int s = 0;
+    while (norm > 0.5)
+    {
+        norm /= 2.0;
+        s++;
+    }
+
+    dense2D<double> B(n, n);
+    B = A * (1.0 / pow(2.0, s));
+
+    dense2D<double> E(n, n);
+    E = 1.0;
+
+    dense2D<double> T(n, n);
+    T = 1.0;
+
+    int k;
+    for (k=1;k<=12;k++)
+    {
+        T = dense2D<double>(T * B) * (1.0 / k);
+        E += T;
+    }
+
+    for (k=0;k<s;k++)
+        E = dense2D<double>(E * E);
+
+    return E;
+}
+
+/*************************************************************************
+  Матрица перехода за время h для углового движения (flag=1),
+  линеаризованного в точке ys.
+ *************************************************************************/
+mtl::dense2D<double> lineartransition(double * ys, double h)
+{
+    return expm(mtl::dense2D<double>(linearize(ys, 1) * h));
+}
+
+/*************************************************************************
+  Отклонение состояния y от точки линеаризации ys: максимум модуля
+  разности по угловой скорости, кватерниону, углам и скоростям панели.
+ *************************************************************************/
+double lineardeviation(double * ys, double * y)
+{
+    double d = 0.0;
+
+    int i;
+    for (i=0;i<11;i++)
+    {
+        if (fabs(y[i]-ys[i]) > d)
+            d = fabs(y[i]-ys[i]);
+    }
+
+    return d;
+}
+
+/*************************************************************************
+  Шаг линейной модели: y = ys + E*(y - ys), с нормировкой кватерниона.
+ *************************************************************************/
+void linearjump(mtl::dense2D<double> & E, double * ys, double * y)
+{
+    using namespace mtl;
+
+    dense_vector <double> dy(12);
+    int i;
+    for (i=0;i<11;i++)
+        dy(i)=y[i]-ys[i];
+    dy(11)=1.0;
+
+    dense_vector <double> dz(12);
+    dz = E*dy;
+
+    for (i=0;i<11;i++)
+        y[i]=ys[i]+dz(i);
+
+    double modul = sqrt(y[3]*y[3]+y[4]*y[4]+y[5]*y[5]+y[6]*y[6]);
+    if (modul != 0)
+    {
+        for (i=3;i<7;i++)
+            y[i]=y[i]/modul;
+    }
+}
@@ -0,0 +1,18 @@
+#ifndef LINEAR_H
+#define LINEAR_H
+
+#include <boost/numeric/mtl/mtl.hpp>
+
+// Перенос точки линеаризации: отклонение состояния от неё
+extern double lineartol;
+
+// Допустимая ошибка линейной модели за кадр в точке линеаризации
+extern double linearerror;
+
+mtl::dense2D<double> linearize(double * ys, int flag);
+mtl::dense2D<double> expm(mtl::dense2D<double> A);
+mtl::dense2D<double> lineartransition(double * ys, double h);
+double lineardeviation(double * ys, double * y);
+void linearjump(mtl::dense2D<double> & E, double * ys, double * y);
+
+#endif // LINEAR_H
@@ -0,0 +1,259 @@
+#include "detector.h"
+#include "modal.h"
+
+// Базис форм консольной панели по умолчанию: 1-й изгиб, кручение, 2-й
+// и 3-й изгиб (ключи mode сценария его заменяют)
+const Mode modalbasis[MAXMODES] =
+{
+    {1.87510407, 0.734095514, 0.05, 0.005},
+    {0.0,        0.0,         0.12, 0.005},
+    {4.69409113, 1.018467319, 0.30, 0.005},
+    {7.85475744, 0.999224497, 0.80, 0.005}
+};
+
+// Базис текущего прогона - из сценария (scenarioapply)
+Mode modes[MAXMODES];
+
+// Число учитываемых форм (0 - жёсткая панель)
+int nmodes = 0;
+
+// Масса панели (та же, что в chainfrompanel) и её ширина поперёк размаха
+double panelmass = 1.0;
+
+double panelwidth = 1.0;
+
+// Размах панели от шарнира, множители нормировки форм на массу и
+// коэффициенты участия относительно шарнира (в системе панели):
+// поворотные L и поступательные P
+static double panelspan = 2.0;
+static double modalnorm[MAXMODES];
+static double modalL[MAXMODES][3];
+static double modalP[MAXMODES][3];
+
+// Форма без нормировки: балочная функция или кручение
+static double modalbasic(int k, double xi, double x)
+{
+    double b = modes[k].beta;
+    if (b == 0.0)
+        return sin(0.5*M_PI*xi)*x;
+
+    return cosh(b*xi) - cos(b*xi) - modes[k].sigma*(sinh(b*xi) - sin(b*xi));
+}
+
+/*************************************************************************
+  Прогиб k-й формы, нормированной на массу (интеграл квадрата по массе
+  панели равен 1), в точке xi = (расстояние от шарнира)/размах,
+  x - поперёк размаха от средней линии.
+ *************************************************************************/
+double modalshape(int k, double xi, double x)
+{
+    return modalnorm[k]*modalbasic(k, xi, x);
+}
+
+/*************************************************************************
+  Подготовка n форм: размах берётся из a2_ (центр масс панели посередине
+  размаха), нормировка и коэффициенты участия - интегралы по массе
+  панели (Симпсон по размаху, по ширине - точно, прогиб линеен по x):
+
+      L_k = int r x (phi_k n) dm,    P_k = int phi_k n dm,
+
+  r - от шарнира, n - нормаль панели (ось z в её системе).
+ *************************************************************************/
+void modalinit(int n)
+{
+    if (n > MAXMODES)
+        n = MAXMODES;
+    if (n < 0)
+        n = 0;
+    nmodes = n;
+
+    panelspan = 2.0*mtl::two_norm(a2_);
+
+    const int N = 400;
+    double w = panelwidth;
+    double x2 = w*w/12.0;       // среднее x^2 по ширине
+
+    int k, i;
+    for (k=0;k<nmodes;k++)
+    {
+        double s0 = 0.0, s1 = 0.0, s2 = 0.0;
+        for (i=0;i<=N;i++)
+        {
+            double xi = (double)i/N;
+            double c = (i == 0 || i == N) ? 1.0 : ((i % 2) ? 4.0 : 2.0);
+            double f = modalbasic(k, xi, 1.0);
+            s0 += c*f;
+            s1 += c*xi*f;
+            s2 += c*f*f;
+        }
+        s0 /= 3.0*N;
+        s1 /= 3.0*N;
+        s2 /= 3.0*N;
+
+        double m = panelmass;
+        double y = panelspan;
+        if (modes[k].beta == 0.0)
+        {
+            // Кручение: прогиб f(xi)*x, нечётен по x
+            modalnorm[k] = 1.0/sqrt(m*s2*x2);
+            modalL[k][0] = 0.0;
+            modalL[k][1] = -modalnorm[k]*m*s0*x2;
+            modalP[k][2] = 0.0;
+        }
+        else
+        {
+            modalnorm[k] = 1.0/sqrt(m*s2);
+            modalL[k][0] = modalnorm[k]*m*y*s1;
+            modalL[k][1] = 0.0;
+            modalP[k][2] = modalnorm[k]*m*s0;
+        }
+        modalL[k][2] = 0.0;
+        modalP[k][0] = 0.0;
+        modalP[k][1] = 0.0;
+    }
+}
+
+// Число шагов Рунге-Кутты на отрезке длины h: не меньше 30 шагов на
+// период старшей формы
+int modalsteps(double h)
+{
+    double fmax = 0.0;
+    int k;
+    for (k=0;k<nmodes;k++)
+    {
+        if (modes[k].frequency > fmax)
+            fmax = modes[k].frequency;
+    }
+
+    int steps = (int)ceil(h*fmax*30.0);
+    return (steps < 10) ? 10 : steps;
+}
+
+/*************************************************************************
+  Правая часть для панели с упругими формами (flag=4). К y[0..10] как
+  для flag=1 добавлены y[11..11+n-1] - модальные координаты eta и
+  y[11+n..11+2n-1] - их скорости, n=nmodes. Уравнения (линейная модель,
+  квадратичные по скоростям связи форм не учитываются):
+
+      S u' + C^T eta'' = v,
+      C u' + eta''     = -2 zeta Om eta' - Om^2 eta,
+
+  u = (omega, psi1', psi2'). Строка C - коэффициенты участия формы,
+  переведённые в обобщённые ускорения: поворотные - через угловое
+  ускорение панели G u', поступательные - через ускорение точки шарнира
+  omega' x a1. Модальный блок единичный, так что он исключается сразу:
+  (S - C^T C) u' = v - C^T fe, eta'' = fe - C u' - система 5x5 при
+  любом числе форм.
+ *************************************************************************/
+void ffmodal(double x, double * y, double * f)
+{
+    using namespace mtl;
+
+    int n = nmodes;
+
+    dense2D<double> T(3, 3);
+    T=B3(y)*B1(y);
+
+    // Угловая скорость панели в её системе: G u
+    dense2D<double> G(3, 5);
+    G=0.0;
+    dense_vector <double> g3(3), g4(3);
+    g3=T*e1;
+    g4=T*dense_vector <double>(trans(B1(y))*e3(y));
+
+    // Скорость точки шарнира в системе панели: H u = T (omega x a1)
+    dense2D<double> A1(3, 3);
+    A1=0.0;
+    A1(0,1)=a1(2);
+    A1(0,2)=-a1(1);
+    A1(1,0)=-a1(2);
+    A1(1,2)=a1(0);
+    A1(2,0)=a1(1);
+    A1(2,1)=-a1(0);
+    dense2D<double> H(3, 3);
+    H=T*A1;
+
+    int i, j, k;
+    for (i=0;i<3;i++)
+    {
+        for (j=0;j<3;j++)
+            G(i,j)=T(i,j);
+        G(i,3)=g3(i);
+        G(i,4)=g4(i);
+    }
+
+    dense2D<double> C(MAXMODES, 5);
+    C=0.0;
+    double fe[MAXMODES];
+    for (k=0;k<n;k++)
+    {
+        for (j=0;j<5;j++)
+        {
+            double s=0.0;
+            for (i=0;i<3;i++)
+            {
+                s+=modalL[k][i]*G(i,j);
+                if (j < 3)
+                    s+=modalP[k][i]*H(i,j);
+            }
+            C(k,j)=s;
+        }
+
+        double om=2.0*M_PI*modes[k].frequency;
+        fe[k]=-2.0*modes[k].damping*om*y[11+n+k] - om*om*y[11+k];
+    }
+
+    dense2D<double> A(5, 5);
+    A=S(y);
+    dense_vector <double> b(5);
+    b=v(y);
+    for (i=0;i<5;i++)
+    {
+        for (j=0;j<5;j++)
+        {
+            for (k=0;k<n;k++)
+                A(i,j)-=C(k,i)*C(k,j);
+        }
+        for (k=0;k<n;k++)
+            b(i)-=C(k,i)*fe[k];
+    }
+
+    dense_vector <double> u(5);
+    u=mat::inv(A)*b;
+
+    for (i=0;i<3;i++)
+        f[i]=u(i);
+
+    dense_vector <double> dqv(4);
+    dqv=dq(y);
+    for (i=3;i<7;i++)
+        f[i]=dqv(i-3);
+
+    f[7]=y[9];
+    f[8]=y[10];
+    f[9]=u(3);
+    f[10]=u(4);
+
+    for (k=0;k<n;k++)
+    {
+        double s=fe[k];
+        for (j=0;j<5;j++)
+            s-=C(k,j)*u(j);
+        f[11+k]=y[11+n+k];
+        f[11+n+k]=s;
+    }
+}
+
+/*************************************************************************
+  Формы для рендерера: число форм, затем для каждой beta, sigma и
+  амплитуда прогиба ненормированной формы (балочная функция или
+  sin(pi xi/2) x).
+ *************************************************************************/
+void modal_print(double * y)
+{
+    file<<nmodes<<" ";
+
+    int k;
+    for (k=0;k<nmodes;k++)
+        file<<modes[k].beta<<" "<<modes[k].sigma<<" "<<modalnorm[k]*y[11+k]<<" ";
+}
@@ -0,0 +1,37 @@
+#ifndef MODAL_H
+#define MODAL_H
+
+// Наибольшее число упругих форм панели
+#define MAXMODES 4
+
+/*************************************************************************
+  Упругая форма панели из заранее посчитанного базиса: прогиб по
+  нормали к панели. beta > 0 - изгиб консольной балки вдоль размаха
+  (балочная функция с параметрами beta, sigma), beta = 0 - кручение
+  sin(pi xi/2) по размаху, линейно поперёк.
+ *************************************************************************/
+struct Mode
+{
+    double beta;
+    double sigma;
+    double frequency;   // Гц
+    double damping;     // доля от критического
+};
+
+extern const Mode modalbasis[MAXMODES];
+
+extern Mode modes[MAXMODES];
+
+extern int nmodes;
+
+extern double panelmass;
+
+extern double panelwidth;
+
+void modalinit(int n);
+double modalshape(int k, double xi, double x);
+int modalsteps(double h);
+void ffmodal(double x, double * y, double * f);
+void modal_print(double * y);
+
+#endif // MODAL_H
@@ -0,0 +1,123 @@
+#include "detector.h"
+#include "parareal.h"
+#include "trace.h"
+
+#include <thread>
+#include <vector>
+
+/*************************************************************************
+  Параллельный по времени метод Parareal.
+
+  Отрезок [x, x1] делится на slices равных частей. Грубый пропагатор G -
+  тот же Рунге-Кутта 4 порядка с coarsesteps шагами на часть, точный F -
+  с finesteps шагами на часть. Точный пропагатор на всех частях
+  считается параллельно, затем значения на границах частей уточняются
+  последовательно:
+
+      U[j+1] = G(U[j]) + F(U_old[j]) - G(U_old[j])
+
+  После k-ой итерации первые k границ совпадают с последовательным
+  решением, так что итерации заведомо сходятся за slices шагов.
+  Останавливаемся, когда поправка на границах меньше tol (смешанная
+  абсолютно-относительная норма, т.к. в векторе состояния соседствуют
+  координаты орбиты и кватернион).
+
+  U - массив (slices+1)*n: на входе U[0..n-1] - начальное состояние,
+  на выходе - состояния на всех границах частей.
+  Возвращает число выполненных итераций.
+ *************************************************************************/
+int solvesystemparareal(int n, double x, double x1, int slices, int finesteps, int coarsesteps,
+                        double * U, int flag, double tol, int maxiter, void (*slice)(int j))
+{
+    int i, j, k;
+    double h = (x1 - x) / slices;
+
+    std::vector<double> F(slices * n);
+    std::vector<double> G(slices * n);
+    std::vector<double> g(n);
+
+    // Нулевое приближение - грубый пропагатор
+    for (j = 0; j < slices; j++)
+    {
+        for (i = 0; i < n; i++)
+            g[i] = U[j * n + i];
+        if (slice)
+            slice(j);
+        solvesystemrungekutta(n, x + j * h, x + (j + 1) * h, coarsesteps, g.data(), flag);
+        for (i = 0; i < n; i++)
+        {
+            G[j * n + i] = g[i];
+            U[(j + 1) * n + i] = g[i];
+        }
+    }
+
+    int threads = std::thread::hardware_concurrency();
+    if (threads < 1)
+        threads = 1;
+
+    for (k = 0; k < maxiter && k < slices; k++)
+    {
+        // Точный пропагатор на ещё не сошедшихся частях, по потокам
+        std::vector<std::thread> pool;
+        int t;
+        for (t = 0; t < threads; t++)
+        {
+            pool.push_back(std::thread([&, t]()
+            {
+                TRACE_ZONE("parareal fine");
+                int jj, ii;
+                for (jj = k + t; jj < slices; jj += threads)
+                {
+                    for (ii = 0; ii < n; ii++)
+                        F[jj * n + ii] = U[jj * n + ii];
+                    if (slice)
+                        slice(jj);
+                    solvesystemrungekutta(n, x + jj * h, x + (jj + 1) * h, finesteps, &F[jj * n], flag);
+                }
+            }));
+        }
+        for (t = 0; t < threads; t++)
+            pool[t].join();
+
+        // Последовательная коррекция
+        double err = 0.0;
+        for (j = k; j < slices; j++)
+        {
+            for (i = 0; i < n; i++)
+                g[i] = U[j * n + i];
+            if (slice)
+                slice(j);
+            solvesystemrungekutta(n, x + j * h, x + (j + 1) * h, coarsesteps, g.data(), flag);
+
+            for (i = 0; i < n; i++)
+            {
+                double temp = g[i] + F[j * n + i] - G[j * n + i];
+                G[j * n + i] = g[i];
+                g[i] = temp;
+            }
+
+            if (flag == 1)
+            {
+                double modul = sqrt(g[3]*g[3]+g[4]*g[4]+g[5]*g[5]+g[6]*g[6]);
+                if (modul != 0)
+                {
+                    for (i = 3; i < 7; i++)
+                        g[i] = g[i]/modul;
+                }
+            }
+
+            for (i = 0; i < n; i++)
+            {
+                double d = fabs(g[i] - U[(j + 1) * n + i]) / (1.0 + fabs(g[i]));
+                if (d > err)
+                    err = d;
+                U[(j + 1) * n + i] = g[i];
+            }
+        }
+
+        if (err < tol)
+            return k + 1;
+    }
+
+    return k;
+}
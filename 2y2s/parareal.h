@@ -0,0 +1,9 @@
+#ifndef PARAREAL_H
+#define PARAREAL_H
+
+// slice(j) вызывается в потоке, считающем часть j, перед её
+// интегрированием - для окружения части (положение на орбите и т.п.)
+int solvesystemparareal(int n, double x, double x1, int slices, int finesteps, int coarsesteps,
+                        double * U, int flag, double tol, int maxiter, void (*slice)(int j) = 0);
+
+#endif // PARAREAL_H
@@ -0,0 +1,824 @@
+#include "detector.h"
+#include "reference.h"
+#include "adaptive.h"
+#include "parareal.h"
+#include "geopotential.h"
+#include "linear.h"
+#include "hingestop.h"
+#include "chain.h"
+#include "modal.h"
+#include "scenario.h"
+
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+// Решение Эйлера-Пуансо для застопоренной панели (тензор Ilock).
+// Главные моменты в порядке a, b, c (b - средний) и главные оси в
+// связанной системе (столбцы rigidaxes)
+static double rigidI[3];
+static double rigidaxes[3][3];
+
+// Амплитуды, частота, параметр m и начальная фаза эллиптических
+// функций; знак dn-компоненты
+static double rigidamp[3];
+static double rigidnu = 0.0;
+static double rigidm = 0.0;
+static double rigidtau0 = 0.0;
+static double rigidsign = 1.0;
+
+// Модуль кинетического момента и удвоенная энергия
+static double rigidH = 0.0;
+static double rigidE2 = 0.0;
+
+// Период |omega| и поворот вокруг H за период
+static double rigidperiod = 0.0;
+static double rigidturn = 0.0;
+
+// Начальные ориентация (инерциальная -> связанная), базис W и углы
+// панели
+static double rigidA0[3][3];
+static double rigidW0[3][3];
+static double rigidpsi[2];
+
+/*************************************************************************
+  RF(x, y, z) Карлсона - удвоение до малой окрестности среднего и ряд
+  (Numerical Recipes, 6.11). Через него - эллиптический интеграл
+  первого рода F(phi|m) для любого phi.
+ *************************************************************************/
+static double carlsonrf(double x, double y, double z)
+{
+    double ave, dx, dy, dz;
+    for (;;)
+    {
+        double sx = sqrt(x), sy = sqrt(y), sz = sqrt(z);
+        double l = sx*(sy + sz) + sy*sz;
+        x = 0.25*(x + l);
+        y = 0.25*(y + l);
+        z = 0.25*(z + l);
+        ave = (x + y + z)/3.0;
+        dx = (ave - x)/ave;
+        dy = (ave - y)/ave;
+        dz = (ave - z)/ave;
+        if (fabs(dx) < 0.0025 && fabs(dy) < 0.0025 && fabs(dz) < 0.0025)
+            break;
+    }
+
+    double e2 = dx*dy - dz*dz;
+    double e3 = dx*dy*dz;
+    return (1.0 + (e2/24.0 - 0.1 - 3.0*e3/44.0)*e2 + e3/14.0)/sqrt(ave);
+}
+
+static double ellipticf(double phi, double m)
+{
+    double n = floor(phi/M_PI + 0.5);
+    double p = phi - n*M_PI;
+    double s = sin(p);
+    double cp = cos(p);
+
+    return s*carlsonrf(cp*cp, 1.0 - m*s*s, 1.0) + 2.0*n*carlsonrf(0.0, 1.0 - m, 1.0);
+}
+
+/*************************************************************************
+  Эллиптические функции Якоби sn, cn, dn (u|m), 0 <= m < 1: спуск по
+  среднему арифметико-геометрическому (Abramowitz, Stegun, 16.4).
+ *************************************************************************/
+static void jacobi(double u, double m, double * sn, double * cn, double * dn)
+{
+    double a[16], g[16];
+    double b = sqrt(1.0 - m);
+    a[0] = 1.0;
+    g[0] = sqrt(m);
+
+    int n = 0;
+    while (fabs(g[n]) > 1e-16 && n < 15)
+    {
+        a[n+1] = 0.5*(a[n] + b);
+        g[n+1] = 0.5*(a[n] - b);
+        b = sqrt(a[n]*b);
+        n++;
+    }
+
+    double phi = ldexp(a[n]*u, n);
+    for (;n>0;n--)
+        phi = 0.5*(phi + asin(g[n]/a[n]*sin(phi)));
+
+    *sn = sin(phi);
+    *cn = cos(phi);
+    *dn = sqrt(1.0 - m*(*sn)*(*sn));
+}
+
+// Собственные числа и векторы симметричной 3x3 матрицы (вращения Якоби)
+static void symeig3(double A[3][3], double lam[3], double V[3][3])
+{
+    int i, j, k, p, sweep;
+    for (i=0;i<3;i++)
+        for (j=0;j<3;j++)
+            V[i][j] = (i == j) ? 1.0 : 0.0;
+
+    for (sweep=0;sweep<50;sweep++)
+    {
+        double off = A[0][1]*A[0][1] + A[0][2]*A[0][2] + A[1][2]*A[1][2];
+        if (off < 1e-30*(A[0][0]*A[0][0] + A[1][1]*A[1][1] + A[2][2]*A[2][2]))
+            break;
+
+        for (p=0;p<2;p++)
+        {
+            for (k=p+1;k<3;k++)
+            {
+                if (A[p][k] == 0.0)
+                    continue;
+                double theta = 0.5*(A[k][k] - A[p][p])/A[p][k];
+                double t = ((theta >= 0) ? 1.0 : -1.0)/(fabs(theta) + sqrt(theta*theta + 1.0));
+                double cs = 1.0/sqrt(t*t + 1.0);
+                double sn = t*cs;
+                for (i=0;i<3;i++)
+                {
+                    double aip = A[i][p], aik = A[i][k];
+                    A[i][p] = cs*aip - sn*aik;
+                    A[i][k] = sn*aip + cs*aik;
+                }
+                for (i=0;i<3;i++)
+                {
+                    double api = A[p][i], aki = A[k][i];
+                    A[p][i] = cs*api - sn*aki;
+                    A[k][i] = sn*api + cs*aki;
+                }
+                for (i=0;i<3;i++)
+                {
+                    double vip = V[i][p], vik = V[i][k];
+                    V[i][p] = cs*vip - sn*vik;
+                    V[i][k] = sn*vip + cs*vik;
+                }
+            }
+        }
+    }
+
+    for (i=0;i<3;i++)
+        lam[i] = A[i][i];
+}
+
+// Матрица ориентации (инерциальная -> связанная) по кватерниону y[3..6]
+// в соглашении кинематики dq = 0.5 OMEGA q: векторная часть первая
+void quaterniontomatrix(double * qv, double A[3][3])
+{
+    double q1 = qv[0], q2 = qv[1], q3 = qv[2], q4 = qv[3];
+
+    A[0][0] = q1*q1 - q2*q2 - q3*q3 + q4*q4;
+    A[0][1] = 2.0*(q1*q2 + q3*q4);
+    A[0][2] = 2.0*(q1*q3 - q2*q4);
+    A[1][0] = 2.0*(q1*q2 - q3*q4);
+    A[1][1] = -q1*q1 + q2*q2 - q3*q3 + q4*q4;
+    A[1][2] = 2.0*(q2*q3 + q1*q4);
+    A[2][0] = 2.0*(q1*q3 + q2*q4);
+    A[2][1] = 2.0*(q2*q3 - q1*q4);
+    A[2][2] = -q1*q1 - q2*q2 + q3*q3 + q4*q4;
+}
+
+// Обратное преобразование (Shepperd): выбирается наибольший из
+// 4q4^2-1 и диагональных элементов, чтобы не делить на малое
+static void matrixtoquaternion(double A[3][3], double * qv)
+{
+    double tr = A[0][0] + A[1][1] + A[2][2];
+
+    if (tr >= A[0][0] && tr >= A[1][1] && tr >= A[2][2])
+    {
+        double q4 = 0.5*sqrt(1.0 + tr);
+        qv[0] = (A[1][2] - A[2][1])/(4.0*q4);
+        qv[1] = (A[2][0] - A[0][2])/(4.0*q4);
+        qv[2] = (A[0][1] - A[1][0])/(4.0*q4);
+        qv[3] = q4;
+    }
+    else if (A[0][0] >= A[1][1] && A[0][0] >= A[2][2])
+    {
+        double q1 = 0.5*sqrt(1.0 + A[0][0] - A[1][1] - A[2][2]);
+        qv[0] = q1;
+        qv[1] = (A[0][1] + A[1][0])/(4.0*q1);
+        qv[2] = (A[0][2] + A[2][0])/(4.0*q1);
+        qv[3] = (A[1][2] - A[2][1])/(4.0*q1);
+    }
+    else if (A[1][1] >= A[2][2])
+    {
+        double q2 = 0.5*sqrt(1.0 - A[0][0] + A[1][1] - A[2][2]);
+        qv[0] = (A[0][1] + A[1][0])/(4.0*q2);
+        qv[1] = q2;
+        qv[2] = (A[1][2] + A[2][1])/(4.0*q2);
+        qv[3] = (A[2][0] - A[0][2])/(4.0*q2);
+    }
+    else
+    {
+        double q3 = 0.5*sqrt(1.0 - A[0][0] - A[1][1] + A[2][2]);
+        qv[0] = (A[0][2] + A[2][0])/(4.0*q3);
+        qv[1] = (A[1][2] + A[2][1])/(4.0*q3);
+        qv[2] = q3;
+        qv[3] = (A[0][1] - A[1][0])/(4.0*q3);
+    }
+}
+
+// Угловая скорость в главных осях (порядок a, b, c)
+static void rigidprincipal(double t, double * w)
+{
+    double sn, cn, dn;
+    jacobi(rigidtau0 + rigidsign*rigidnu*t, rigidm, &sn, &cn, &dn);
+
+    w[0] = rigidamp[0]*cn;
+    w[1] = rigidamp[1]*sn;
+    w[2] = rigidsign*rigidamp[2]*dn;
+}
+
+// Скорость поворота вокруг H средней главной оси b (Landau, Lifshitz,
+// "Механика", 37): H (Ia wa^2 + Ic wc^2)/(Ia^2 wa^2 + Ic^2 wc^2)
+static double rigidprecession(double t)
+{
+    double w[3];
+    rigidprincipal(t, w);
+
+    double ha = rigidI[0]*w[0];
+    double hc = rigidI[2]*w[2];
+    return rigidH*(ha*w[0] + hc*w[2])/(ha*ha + hc*hc);
+}
+
+// Поворот вокруг H от 0 до t: целые периоды плюс остаток по Гауссу
+static double rigidangle(double t)
+{
+    static const double gx[4] = {0.1834346424956498, 0.5255324099163290,
+                                 0.7966664774136267, 0.9602898564975363};
+    static const double gw[4] = {0.3626837833783620, 0.3137066458778873,
+                                 0.2223810344533745, 0.1012285362903763};
+
+    double full = floor(t/rigidperiod);
+    double rest = t - full*rigidperiod;
+
+    int panels = (int)ceil(32.0*rest/rigidperiod) + 1;
+    double h = rest/panels;
+    double sum = 0.0;
+    int i, k;
+    for (i=0;i<panels;i++)
+    {
+        double mid = (i + 0.5)*h;
+        for (k=0;k<4;k++)
+        {
+            sum += gw[k]*rigidprecession(mid - 0.5*h*gx[k]);
+            sum += gw[k]*rigidprecession(mid + 0.5*h*gx[k]);
+        }
+    }
+
+    return full*rigidturn + 0.5*h*sum;
+}
+
+// Базис W: строки - единичные векторы в связанной системе, третий - по
+// кинетическому моменту, первый - проекция средней главной оси
+static void rigidframe(double t, double W[3][3])
+{
+    double w[3];
+    rigidprincipal(t, w);
+
+    double u[3], bax[3];
+    int i, k;
+    for (i=0;i<3;i++)
+    {
+        u[i] = 0.0;
+        for (k=0;k<3;k++)
+            u[i] += rigidaxes[i][k]*rigidI[k]*w[k];
+        u[i] /= rigidH;
+        bax[i] = rigidaxes[i][1];
+    }
+
+    double d = bax[0]*u[0] + bax[1]*u[1] + bax[2]*u[2];
+    double n = 0.0;
+    for (i=0;i<3;i++)
+    {
+        W[0][i] = bax[i] - d*u[i];
+        n += W[0][i]*W[0][i];
+    }
+    n = sqrt(n);
+    for (i=0;i<3;i++)
+    {
+        W[0][i] /= n;
+        W[2][i] = u[i];
+    }
+    W[1][0] = u[1]*W[0][2] - u[2]*W[0][1];
+    W[1][1] = u[2]*W[0][0] - u[0]*W[0][2];
+    W[1][2] = u[0]*W[0][1] - u[1]*W[0][0];
+}
+
+/*************************************************************************
+  Подготовка точного решения для твёрдого тела без внешних моментов
+  (flag=2, тензор Ilock - вызывается после lockpanel). В главных осях
+  a, b, c (Ib - средний, вращение вокруг оси c, т.е. H^2 > 2T Ib, иначе
+  оси a и c меняются местами):
+
+      wa = Aa cn(tau), wb = Ab sn(tau), wc = +-Ac dn(tau),
+      tau = tau0 +- nu t.
+
+  Ориентация: H неподвижен в инерциальной системе, базис W (H и
+  проекция оси b) поворачивается вокруг H на угол phi(t) - интеграл
+  третьего рода, берётся квадратурой гладкой периодической функции.
+  Сепаратриса (H^2 = 2T Ib) не рассматривается.
+ *************************************************************************/
+void rigidreferenceinit(double * y)
+{
+    double A[3][3], lam[3], V[3][3];
+    int i, j, k;
+    for (i=0;i<3;i++)
+        for (j=0;j<3;j++)
+            A[i][j] = Ilock(i,j);
+    symeig3(A, lam, V);
+
+    // По возрастанию момента, правая тройка осей
+    int order[3] = {0, 1, 2};
+    for (i=0;i<2;i++)
+        for (j=i+1;j<3;j++)
+            if (lam[order[j]] < lam[order[i]])
+            {
+                k = order[i];
+                order[i] = order[j];
+                order[j] = k;
+            }
+
+    double Ip[3], P[3][3];
+    for (k=0;k<3;k++)
+    {
+        Ip[k] = lam[order[k]];
+        for (i=0;i<3;i++)
+            P[i][k] = V[i][order[k]];
+    }
+    double det = P[0][0]*(P[1][1]*P[2][2] - P[1][2]*P[2][1])
+               - P[0][1]*(P[1][0]*P[2][2] - P[1][2]*P[2][0])
+               + P[0][2]*(P[1][0]*P[2][1] - P[1][1]*P[2][0]);
+    if (det < 0)
+        for (i=0;i<3;i++)
+            P[i][2] = -P[i][2];
+
+    double wp[3];
+    rigidE2 = 0.0;
+    double H2 = 0.0;
+    for (k=0;k<3;k++)
+    {
+        wp[k] = 0.0;
+        for (i=0;i<3;i++)
+            wp[k] += P[i][k]*y[i];
+        rigidE2 += Ip[k]*wp[k]*wp[k];
+        H2 += Ip[k]*Ip[k]*wp[k]*wp[k];
+    }
+    rigidH = sqrt(H2);
+
+    // Вращение вокруг оси наименьшего момента - оси a и c меняются
+    // местами. Тройка становится левой, уравнения Эйлера меняют знак,
+    // но вместе с ним меняют знак и разности моментов, так что связь
+    // tau' = +-nu со знаком wc остаётся той же
+    int lab[3] = {0, 1, 2};
+    if (H2 < rigidE2*Ip[1])
+    {
+        lab[0] = 2;
+        lab[2] = 0;
+    }
+
+    double w0[3];
+    for (k=0;k<3;k++)
+    {
+        rigidI[k] = Ip[lab[k]];
+        w0[k] = wp[lab[k]];
+        for (i=0;i<3;i++)
+            rigidaxes[i][k] = P[i][lab[k]];
+    }
+
+    double Ia = rigidI[0], Ib = rigidI[1], Ic = rigidI[2];
+    rigidamp[0] = sqrt(fabs((rigidE2*Ic - H2)/(Ia*(Ic - Ia))));
+    rigidamp[1] = sqrt(fabs((rigidE2*Ic - H2)/(Ib*(Ic - Ib))));
+    rigidamp[2] = sqrt(fabs((H2 - rigidE2*Ia)/(Ic*(Ic - Ia))));
+    rigidnu = sqrt(fabs((Ic - Ib)*(H2 - rigidE2*Ia)/(Ia*Ib*Ic)));
+    rigidm = fabs((Ib - Ia)*(rigidE2*Ic - H2)/((Ic - Ib)*(H2 - rigidE2*Ia)));
+    if (rigidm > 1.0 - 1e-12)
+        rigidm = 1.0 - 1e-12;
+
+    rigidsign = (w0[2] < 0) ? -1.0 : 1.0;
+    double cn0 = (rigidamp[0] > 0) ? w0[0]/rigidamp[0] : 1.0;
+    double sn0 = (rigidamp[1] > 0) ? w0[1]/rigidamp[1] : 0.0;
+    rigidtau0 = ellipticf(atan2(sn0, cn0), rigidm);
+
+    // Квадрат |omega| в главных осях имеет период 2K по tau
+    rigidperiod = 2.0*carlsonrf(0.0, 1.0 - rigidm, 1.0)/rigidnu;
+    const int N = 128;
+    rigidturn = 0.0;
+    for (i=0;i<N;i++)
+        rigidturn += rigidprecession(i*rigidperiod/N);
+    rigidturn *= rigidperiod/N;
+
+    quaterniontomatrix(y + 3, rigidA0);
+    rigidframe(0.0, rigidW0);
+    rigidpsi[0] = y[7];
+    rigidpsi[1] = y[8];
+}
+
+// Угловая скорость в связанной системе в момент t
+void rigidomega(double t, double * w)
+{
+    double wp[3];
+    rigidprincipal(t, wp);
+
+    int i, k;
+    for (i=0;i<3;i++)
+    {
+        w[i] = 0.0;
+        for (k=0;k<3;k++)
+            w[i] += rigidaxes[i][k]*wp[k];
+    }
+}
+
+/*************************************************************************
+  Точное состояние y[0..10] в момент t: ориентация (инерциальная ->
+  связанная) A(t) = W(t)^T Rz(-phi) W(0) A(0), углы панели начальные,
+  их скорости нулевые.
+ *************************************************************************/
+void rigidreference(double t, double * y)
+{
+    rigidomega(t, y);
+
+    double W[3][3];
+    rigidframe(t, W);
+    double phi = rigidangle(t);
+    double cp = cos(phi), sp = sin(phi);
+
+    double B[3][3], C[3][3], A[3][3];
+    int i, j, k;
+    for (i=0;i<3;i++)
+        for (j=0;j<3;j++)
+        {
+            B[i][j] = 0.0;
+            for (k=0;k<3;k++)
+                B[i][j] += rigidW0[i][k]*rigidA0[k][j];
+        }
+    for (j=0;j<3;j++)
+    {
+        C[0][j] = cp*B[0][j] + sp*B[1][j];
+        C[1][j] = -sp*B[0][j] + cp*B[1][j];
+        C[2][j] = B[2][j];
+    }
+    for (i=0;i<3;i++)
+        for (j=0;j<3;j++)
+        {
+            A[i][j] = 0.0;
+            for (k=0;k<3;k++)
+                A[i][j] += W[k][i]*C[k][j];
+        }
+
+    matrixtoquaternion(A, y + 3);
+    y[7] = rigidpsi[0];
+    y[8] = rigidpsi[1];
+    y[9] = 0.0;
+    y[10] = 0.0;
+}
+
+// Ошибка ориентации: расстояние между кватернионами с точностью до знака
+double quaternionerror(double * y, double * yr)
+{
+    double dp = 0.0, dm = 0.0;
+    int i;
+    for (i=3;i<7;i++)
+    {
+        dp += (y[i] - yr[i])*(y[i] - yr[i]);
+        dm += (y[i] + yr[i])*(y[i] + yr[i]);
+    }
+    return sqrt((dp < dm) ? dp : dm);
+}
+
+/*************************************************************************
+  Точное решение задачи двух тел (flag=0 при geodegree=0) для
+  эллиптической орбиты: элементы по начальному состоянию y0, уравнение
+  Кеплера - Ньютоном до сходимости.
+ *************************************************************************/
+void keplerreference(const double * y0, double t, double * y)
+{
+    double rn = sqrt(y0[0]*y0[0] + y0[1]*y0[1] + y0[2]*y0[2]);
+    double v2 = y0[3]*y0[3] + y0[4]*y0[4] + y0[5]*y0[5];
+    double rv = y0[0]*y0[3] + y0[1]*y0[4] + y0[2]*y0[5];
+    double hv[3] = {y0[1]*y0[5] - y0[2]*y0[4], y0[2]*y0[3] - y0[0]*y0[5], y0[0]*y0[4] - y0[1]*y0[3]};
+    double hn = sqrt(hv[0]*hv[0] + hv[1]*hv[1] + hv[2]*hv[2]);
+
+    double a = 1.0/(2.0/rn - v2/M);
+    double ev[3];
+    int i;
+    for (i=0;i<3;i++)
+        ev[i] = ((v2 - M/rn)*y0[i] - rv*y0[3+i])/M;
+    double e = sqrt(ev[0]*ev[0] + ev[1]*ev[1] + ev[2]*ev[2]);
+
+    double P[3], Q[3];
+    double E0;
+    if (e < 1e-12)
+    {
+        e = 0.0;
+        for (i=0;i<3;i++)
+            P[i] = y0[i]/rn;
+        E0 = 0.0;
+    }
+    else
+    {
+        for (i=0;i<3;i++)
+            P[i] = ev[i]/e;
+        E0 = atan2(rv/sqrt(M*a), 1.0 - rn/a);
+    }
+    Q[0] = (hv[1]*P[2] - hv[2]*P[1])/hn;
+    Q[1] = (hv[2]*P[0] - hv[0]*P[2])/hn;
+    Q[2] = (hv[0]*P[1] - hv[1]*P[0])/hn;
+
+    double n = sqrt(M/(a*a*a));
+    double b = a*sqrt(1.0 - e*e);
+    double Ma = E0 - e*sin(E0) + n*t;
+    double E = Ma;
+    int it;
+    for (it=0;it<50;it++)
+    {
+        double d = (E - e*sin(E) - Ma)/(1.0 - e*cos(E));
+        E -= d;
+        if (fabs(d) < 1e-15)
+            break;
+    }
+
+    double cE = cos(E), sE = sin(E);
+    double Ed = n/(1.0 - e*cE);
+    for (i=0;i<3;i++)
+    {
+        y[i] = a*(cE - e)*P[i] + b*sE*Q[i];
+        y[3+i] = -a*sE*Ed*P[i] + b*cE*Ed*Q[i];
+    }
+}
+
+/*************************************************************************
+  Наибольшее по компонентам отклонение состояния от эталонного (задачи
+  без точного решения, эталон - тот же интегратор с мелким шагом).
+ *************************************************************************/
+static double stateerror(int n, const double * y, const double * yr)
+{
+    double err = 0.0;
+    int i;
+    for (i=0;i<n;i++)
+    {
+        if (fabs(y[i] - yr[i]) > err)
+            err = fabs(y[i] - yr[i]);
+    }
+    return err;
+}
+
+/*************************************************************************
+  Один кадр интегратора method задачи с подвижной панелью: Рунге-Кутта
+  полной модели, переключение на застопоренную панель (model - текущая
+  модель), экспонента матрицы линейной модели с переносом точки
+  линеаризации на каждом шаге, упоры, дерево тел и упругие формы.
+ *************************************************************************/
+static void benchmarkframe(int method, double x, double x1, int steps, double * y, int * model)
+{
+    int i;
+    if (method == 4)
+        solvesystemadaptive(11, x, x1, steps, y, model);
+    else if (method == 5)
+    {
+        double h = (x1 - x)/steps;
+        double ys[11];
+        for (i=0;i<steps;i++)
+        {
+            int k;
+            for (k=0;k<11;k++)
+                ys[k] = y[k];
+            mtl::dense2D<double> E = lineartransition(ys, h);
+            linearjump(E, ys, y);
+        }
+    }
+    else if (method == 6)
+        solvesystemstops(11, x, x1, steps, y, 1);
+    else if (method == 7)
+        solvesystemrungekutta(7+2*chaindof(), x, x1, steps, y, 3);
+    else if (method == 8)
+        solvesystemrungekutta(11+2*nmodes, x, x1, steps, y, 4);
+    else
+        solvesystemrungekutta(11, x, x1, steps, y, 1);
+}
+
+/*************************************************************************
+  Сравнение интеграторов при разном числе шагов на кадр в 10 с. С
+  точными решениями, 150 кадров: Рунге-Кутта и Parareal для застопоренной
+  панели (ошибка кватерниона) и Рунге-Кутта для орбиты (ошибка
+  положения, м). С подвижной панелью, 30 кадров (эталон - та же модель с
+  шагом в 10 раз мельче самого мелкого, ошибка - наибольшая по
+  компонентам состояния): Рунге-Кутта, переключение моделей, линейная
+  модель через экспоненту матрицы, упоры, дерево тел и упругие формы (у
+  них шагов - от modalsteps, иначе схема неустойчива).
+
+  Для каждого прогона - число вычислений правой части и время; таблица
+  пишется в integrators.csv, integrators.gp рисует ошибку от числа
+  вычислений и от времени. Для каждого интегратора выводится наименьшее
+  число шагов на кадр, при котором ошибка не больше допуска.
+ *************************************************************************/
+void integratorbenchmark(double * y, double * result)
+{
+    const int frames = 150;
+    const int panelframes = 30;
+    const double frame = 10.0;
+    const int nsteps = 7;
+    const int stepcounts[nsteps] = {1, 2, 5, 10, 20, 50, 100};
+
+    // Допуски: кватернион, положение на орбите (м), состояние с
+    // подвижной панелью
+    const double rigidtol = 1e-6;
+    const double orbittol = 1e-3;
+    const double paneltol = 1e-6;
+
+    // Вращение быстрее, чем в main, иначе за 1500 с ошибки всех
+    // прогонов на уровне округления; у подвижной панели - ещё и
+    // начальная скорость шарнира
+    double y0[11+2*MAXMODES], yp[11+2*MAXMODES];
+    int i, j, s;
+    for (i=0;i<11+2*MAXMODES;i++)
+        y0[i] = (i < 11) ? y[i] : 0.0;
+    y0[0] = 0.05;
+    y0[1] = 0.02;
+    y0[2] = 0.1;
+    for (i=0;i<11+2*MAXMODES;i++)
+        yp[i] = y0[i];
+    yp[9] = 0.01;
+    lockpanel(y0);
+    rigidreferenceinit(y0);
+
+    int savedgeo = geodegree;
+    geopotentialinit(0);
+
+    // Упоры и касание корпуса - как у -stops со сценарием по умолчанию;
+    // дерево тел и упругие формы - как у -chain и -modal
+    double savedpsimin[2] = {psimin[0], psimin[1]};
+    double savedpsimax[2] = {psimax[0], psimax[1]};
+    int savedcontacts = ncontactpoints;
+    int savedmodes = nmodes;
+    Scenario def;
+    scenariodefault(def);
+    stopsinit(def);
+    chainfrompanel();
+    modalinit(def.modes);
+
+    std::ofstream csv("integrators.csv");
+    csv<<"integrator,problem,steps,h,rhs,seconds,error"<<std::endl;
+
+    const int methods = 9;
+    const char * names[methods] = {"rk4", "parareal", "rk4", "rk4", "adaptive", "expm", "stops", "chain", "modal"};
+    const char * problems[methods] = {"rigid", "rigid", "orbit", "panel", "panel", "panel", "panel", "panel", "panel"};
+    double tols[methods] = {rigidtol, rigidtol, orbittol, paneltol, paneltol, paneltol, paneltol, paneltol, paneltol};
+    int recommended[methods] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
+
+    // Решения-эталоны на концах кадров - до замеров времени: точные и
+    // мелким шагом (у адаптивного и линейного - полная модель)
+    int ns = 11+2*nmodes;
+    int minmodal = modalsteps(frame);
+    std::vector<double> rigidref(frames*11), orbitref(frames*6);
+    std::vector<double> panelref(panelframes*ns), stopsref(panelframes*ns);
+    std::vector<double> chainref(panelframes*ns), modalref(panelframes*ns);
+    double ys[11+2*MAXMODES], orb[6];
+    for (j=0;j<frames;j++)
+    {
+        rigidreference(frame*(j+1), &rigidref[j*11]);
+        keplerreference(result, frame*(j+1), &orbitref[j*6]);
+    }
+    int method;
+    for (method=3;method<methods;method++)
+    {
+        std::vector<double> * ref = (method == 6) ? &stopsref : (method == 7) ? &chainref
+                                  : (method == 8) ? &modalref : &panelref;
+        if (method == 4 || method == 5)
+            continue;
+        int model = 1;
+        for (i=0;i<ns;i++)
+            ys[i] = yp[i];
+        int refsteps = 10*((method == 8) ? minmodal*(nsteps + 1)/2 : stepcounts[nsteps-1]);
+        for (j=0;j<panelframes;j++)
+        {
+            benchmarkframe(method, frame*j, frame*(j+1), refsteps, ys, &model);
+            for (i=0;i<ns;i++)
+                (*ref)[j*ns+i] = ys[i];
+        }
+    }
+
+    std::vector<double> U((frames + 1)*11);
+
+    for (method=0;method<methods;method++)
+    {
+        for (s=0;s<nsteps;s++)
+        {
+            int steps = stepcounts[s];
+            if (method == 8)
+                steps = minmodal*(s + 2)/2;
+            double error = 0.0;
+            long calls0 = rhscalls;
+            auto t0 = std::chrono::steady_clock::now();
+
+            if (method == 0)
+            {
+                for (i=0;i<11;i++)
+                    ys[i] = y0[i];
+                for (j=0;j<frames;j++)
+                {
+                    solvesystemrungekutta(11, frame*j, frame*(j+1), steps, ys, 2);
+                    double err = quaternionerror(ys, &rigidref[j*11]);
+                    if (err > error)
+                        error = err;
+                }
+            }
+            else if (method == 1)
+            {
+                for (i=0;i<11;i++)
+                    U[i] = y0[i];
+                solvesystemparareal(11, 0, frames*frame, frames, steps, 1, &U[0], 2, 1e-12, frames);
+                for (j=0;j<frames;j++)
+                {
+                    double err = quaternionerror(&U[(j+1)*11], &rigidref[j*11]);
+                    if (err > error)
+                        error = err;
+                }
+            }
+            else if (method == 2)
+            {
+                for (i=0;i<6;i++)
+                    orb[i] = result[i];
+                for (j=0;j<frames;j++)
+                {
+                    solvesystemrungekutta(6, frame*j, frame*(j+1), steps, orb, 0);
+                    double * ref = &orbitref[j*6];
+                    double err = sqrt((orb[0] - ref[0])*(orb[0] - ref[0])
+                                    + (orb[1] - ref[1])*(orb[1] - ref[1])
+                                    + (orb[2] - ref[2])*(orb[2] - ref[2]));
+                    if (err > error)
+                        error = err;
+                }
+            }
+            else
+            {
+                const std::vector<double> & ref = (method == 6) ? stopsref : (method == 7) ? chainref
+                                                : (method == 8) ? modalref : panelref;
+                int n = (method == 8) ? ns : 11;
+                int model = 1;
+                for (i=0;i<ns;i++)
+                    ys[i] = yp[i];
+                for (j=0;j<panelframes;j++)
+                {
+                    benchmarkframe(method, frame*j, frame*(j+1), steps, ys, &model);
+                    double err = stateerror(n, ys, &ref[j*ns]);
+                    if (err > error)
+                        error = err;
+                }
+            }
+
+            auto t1 = std::chrono::steady_clock::now();
+            double seconds = std::chrono::duration<double>(t1 - t0).count();
+            long calls = rhscalls - calls0;
+
+            if (error <= tols[method] && recommended[method] == 0)
+                recommended[method] = steps;
+
+            csv<<names[method]<<","<<problems[method]<<","<<steps<<","<<frame/steps<<","
+               <<calls<<","<<seconds<<","<<error<<std::endl;
+            std::cout<<names[method]<<" "<<problems[method]<<" STEPS "<<steps
+                     <<" RHS "<<calls<<" TIME "<<seconds<<" s ERROR "<<error<<std::endl;
+        }
+    }
+    csv.close();
+
+    for (method=0;method<methods;method++)
+    {
+        std::cout<<names[method]<<" "<<problems[method]<<" STEPS PER FRAME FOR "<<tols[method]<<": ";
+        if (recommended[method])
+            std::cout<<recommended[method]<<std::endl;
+        else
+            std::cout<<"MORE THAN "<<stepcounts[nsteps-1]<<std::endl;
+    }
+
+    // Два графика: ошибка от числа вычислений правой части (столбец 5)
+    // и от времени (столбец 6)
+    std::ofstream gp("integrators.gp");
+    gp<<"set datafile separator ','"<<std::endl;
+    gp<<"set logscale xy"<<std::endl;
+    gp<<"set ylabel 'max error'"<<std::endl;
+    gp<<"set key outside"<<std::endl;
+    gp<<"set multiplot layout 2,1"<<std::endl;
+    int col;
+    for (col=5;col<=6;col++)
+    {
+        gp<<"set xlabel '"<<((col == 5) ? "RHS evaluations" : "seconds")<<"'"<<std::endl;
+        gp<<"plot";
+        for (method=0;method<methods;method++)
+        {
+            // Строки прогонов одного интегратора идут подряд после заголовка
+            gp<<((method > 0) ? ", \\\n    " : " ")<<"'integrators.csv' every ::"<<1 + method*nsteps<<"::"
+              <<(method + 1)*nsteps<<" using "<<col<<":7 with linespoints title '"
+              <<names[method]<<" "<<problems[method]<<"'";
+        }
+        gp<<std::endl;
+    }
+    gp<<"unset multiplot"<<std::endl;
+    gp.close();
+
+    for (i=0;i<2;i++)
+    {
+        psimin[i] = savedpsimin[i];
+        psimax[i] = savedpsimax[i];
+    }
+    ncontactpoints = savedcontacts;
+    nmodes = savedmodes;
+    geopotentialinit(savedgeo);
+}
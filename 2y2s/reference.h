@@ -0,0 +1,12 @@
+#ifndef REFERENCE_H
+#define REFERENCE_H
+
+void rigidreferenceinit(double * y);
+void rigidomega(double t, double * w);
+void rigidreference(double t, double * y);
+double quaternionerror(double * y, double * yr);
+void quaterniontomatrix(double * qv, double A[3][3]);
+void keplerreference(const double * y0, double t, double * y);
+void integratorbenchmark(double * y, double * result);
+
+#endif // REFERENCE_H
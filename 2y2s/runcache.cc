@@ -0,0 +1,155 @@
+#include "detector.h"
+#include "runcache.h"
+#include "modal.h"
+#include "srp.h"
+#include "geopotential.h"
+#include "binfile.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Признак файла кэша ("RUN1")
+#define RUNCACHEMAGIC 0x314e5552
+
+// Итоги кэша за процесс: полное совпадение, продолжение более короткого
+// прогона, прогон с нуля
+int runcachehits = 0;
+
+int runcachepartial = 0;
+
+int runcachemisses = 0;
+
+/*************************************************************************
+  Канонический ключ прогона - всё, от чего зависит траектория: версия
+  модели, параметры сценария кроме числа кадров и вывода, длина вектора
+  состояния n (упругие формы и их базис) и глобальные режимы правой
+  части. Отрицательный ноль приводится к нулю, чтобы "-0" и "0" в
+  файлах сценариев давали один ключ.
+ *************************************************************************/
+void runcachekey(const Scenario & sc, int n, std::vector<double> & key)
+{
+    int i;
+    key.clear();
+    key.push_back(RUNCACHEVERSION);
+    for (i=0;i<9;i++)
+        key.push_back(sc.I1[i]);
+    for (i=0;i<9;i++)
+        key.push_back(sc.I2[i]);
+    for (i=0;i<3;i++)
+    {
+        key.push_back(sc.a1[i]);
+        key.push_back(sc.a2[i]);
+        key.push_back(sc.e1[i]);
+        key.push_back(sc.c[i]);
+        key.push_back(sc.sun[i]);
+    }
+    for (i=0;i<11;i++)
+        key.push_back(sc.y[i]);
+    for (i=0;i<6;i++)
+        key.push_back(sc.orbit[i]);
+    key.push_back(sc.frame);
+    key.push_back(sc.steps);
+    key.push_back(sc.orbitsteps);
+
+    key.push_back(n);
+    key.push_back(nmodes);
+    for (i=0;i<nmodes;i++)
+    {
+        key.push_back(sc.basis[i].beta);
+        key.push_back(sc.basis[i].sigma);
+        key.push_back(sc.basis[i].frequency);
+        key.push_back(sc.basis[i].damping);
+    }
+    key.push_back(srp);
+    key.push_back(srpspecular);
+    key.push_back(srpdiffuse);
+    key.push_back(gravitygradient);
+    key.push_back(geodegree);
+
+    for (i=0;i<(int)key.size();i++)
+    {
+        if (key[i] == 0.0)
+            key[i] = 0.0;
+    }
+}
+
+// FNV-1a по байтам ключа
+unsigned long long runcachehash(const std::vector<double> & key)
+{
+    const unsigned char * p = (const unsigned char *)key.data();
+    size_t size = key.size()*sizeof(double);
+    unsigned long long h = 14695981039346656037ULL;
+    size_t i;
+    for (i=0;i<size;i++)
+    {
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+std::string runcachename(const char * dir, const std::vector<double> & key)
+{
+    char hex[17];
+    snprintf(hex, sizeof(hex), "%016llx", runcachehash(key));
+    return std::string(dir) + "/" + hex + ".run";
+}
+
+/*************************************************************************
+  Файл кэша: признак, длина ключа, сам ключ (сверяется целиком, так что
+  совпадение хэшей не подменит прогон), число кадров и столбцов и
+  строки кадров. Возвращает число кадров в кэше, 0 - если прогона нет.
+ *************************************************************************/
+int runcacheload(const char * dir, const std::vector<double> & key, int cols, std::vector<double> & rows)
+{
+    std::ifstream in(runcachename(dir, key).c_str(), std::ios::binary);
+    if (!in)
+        return 0;
+
+    int magic = 0, keysize = 0, frames = 0, filecols = 0;
+    in.read((char *)&magic, sizeof(int));
+    in.read((char *)&keysize, sizeof(int));
+    if (!in || magic != RUNCACHEMAGIC || keysize != (int)key.size()
+        || (long long)keysize*(long long)sizeof(double) > fileremaining(in))
+        return 0;
+
+    std::vector<double> filekey(keysize);
+    in.read((char *)filekey.data(), keysize*sizeof(double));
+    if (!in || memcmp(filekey.data(), key.data(), keysize*sizeof(double)) != 0)
+        return 0;
+
+    in.read((char *)&frames, sizeof(int));
+    in.read((char *)&filecols, sizeof(int));
+    if (!in || frames < 1 || filecols != cols
+        || (long long)frames*cols*(long long)sizeof(double) != fileremaining(in))
+        return 0;
+
+    rows.resize(frames*cols);
+    in.read((char *)rows.data(), rows.size()*sizeof(double));
+
+    return in.good() ? frames : 0;
+}
+
+// Запись через filetemp и filereplace: параллельные прогоны с тем же
+// ключом не увидят недописанный файл
+int runcachesave(const char * dir, const std::vector<double> & key, int frames, int cols,
+                 const std::vector<double> & rows)
+{
+    std::string name = runcachename(dir, key);
+    std::string temp = filetemp(name);
+
+    std::ofstream out(temp.c_str(), std::ios::binary);
+    if (!out)
+        return 0;
+
+    int magic = RUNCACHEMAGIC;
+    int keysize = (int)key.size();
+    out.write((const char *)&magic, sizeof(int));
+    out.write((const char *)&keysize, sizeof(int));
+    out.write((const char *)key.data(), keysize*sizeof(double));
+    out.write((const char *)&frames, sizeof(int));
+    out.write((const char *)&cols, sizeof(int));
+    out.write((const char *)rows.data(), (size_t)frames*cols*sizeof(double));
+
+    return filereplace(out, temp, name);
+}
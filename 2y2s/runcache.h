@@ -0,0 +1,26 @@
+#ifndef RUNCACHE_H
+#define RUNCACHE_H
+
+#include <vector>
+#include <string>
+
+#include "scenario.h"
+
+// Версия модели в ключе кэша: увеличивать при любом изменении ff,
+// интеграторов или начальной подготовки прогона, меняющем траекторию
+#define RUNCACHEVERSION 1
+
+extern int runcachehits;
+
+extern int runcachepartial;
+
+extern int runcachemisses;
+
+void runcachekey(const Scenario & sc, int n, std::vector<double> & key);
+unsigned long long runcachehash(const std::vector<double> & key);
+std::string runcachename(const char * dir, const std::vector<double> & key);
+int runcacheload(const char * dir, const std::vector<double> & key, int cols, std::vector<double> & rows);
+int runcachesave(const char * dir, const std::vector<double> & key, int frames, int cols,
+                 const std::vector<double> & rows);
+
+#endif // RUNCACHE_H
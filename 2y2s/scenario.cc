@@ -0,0 +1,410 @@
+#include "detector.h"
+#include "scenario.h"
+#include "modal.h"
+
+#include <string.h>
+#include <sstream>
+#include <algorithm>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/*************************************************************************
+  Константы прежнего main(): прогон без файла сценария совпадает с ним
+  побитно.
+ *************************************************************************/
+void scenariodefault(Scenario & sc)
+{
+    int i;
+    sc.name = "output";
+    sc.output = "output.txt";
+
+    for (i=0;i<9;i++)
+    {
+        sc.I1[i] = 0.0;
+        sc.I2[i] = 0.0;
+    }
+    sc.I1[0] = 38.57;
+    sc.I1[4] = 29.05;
+    sc.I1[8] = 33.96;
+    sc.I2[0] = 5.549;
+    sc.I2[4] = 1.757;
+    sc.I2[8] = 7.304;
+
+    for (i=0;i<3;i++)
+    {
+        sc.a1[i] = 0.0;
+        sc.a2[i] = 0.0;
+        sc.e1[i] = 0.0;
+        sc.c[i] = 0.0;
+        sc.sun[i] = 0.0;
+    }
+    // Прежнее положение шарнира: (0.0094, -0.4489, -0.1268)
+    sc.a1[1] = 0.5;
+    sc.a2[1] = 1.0;
+    sc.e1[1] = 1.0;
+    sc.c[1] = 0.5;
+    sc.c[2] = 0.5;
+    sc.sun[1] = 150000000000;
+
+    for (i=0;i<11;i++)
+        sc.y[i] = 0.0;
+    sc.y[0] = 0.001;
+    sc.y[1] = 0.001;
+    sc.y[2] = 0.001;
+    sc.y[3] = 1.0;
+    sc.y[9] = 0.001;
+    sc.y[10] = 0.001;
+
+    sc.orbit[0] = 0;
+    sc.orbit[1] = 6500000;
+    sc.orbit[2] = 0;
+    sc.orbit[3] = sqrt(M/6500000);
+    sc.orbit[4] = 0;
+    sc.orbit[5] = 0;
+
+    sc.frames = 150;
+    sc.frame = 10;
+    sc.steps = 10;
+    sc.orbitsteps = 10;
+    sc.every = 1;
+
+    sc.modes = 3;
+    for (i=0;i<MAXMODES;i++)
+        sc.basis[i] = modalbasis[i];
+
+    // Упор по первому углу и касание корпуса дальним краем панели
+    static const double corners[MAXCONTACTS][3] = {
+        {-0.5, 1.0, 0.01}, {0.5, 1.0, 0.01}, {-0.5, 1.0, -0.01}, {0.5, 1.0, -0.01}
+    };
+    sc.psimin[0] = -1.5;
+    sc.psimin[1] = -1e9;
+    sc.psimax[0] = 1.5;
+    sc.psimax[1] = 1e9;
+    sc.contacts = MAXCONTACTS;
+    for (i=0;i<MAXCONTACTS;i++)
+    {
+        int j;
+        for (j=0;j<3;j++)
+            sc.contact[i][j] = corners[i][j];
+    }
+}
+
+// Ключ файла сценария: куда читать и сколько чисел (two - второй
+// допустимый размер, для тензоров 3 числа - диагональ)
+struct ScenarioKey
+{
+    const char * key;
+    int count;
+    int two;
+};
+
+static const ScenarioKey scenariokeys[] = {
+    {"I1", 9, 3}, {"I2", 9, 3},
+    {"a1", 3, 0}, {"a2", 3, 0}, {"e1", 3, 0}, {"c", 3, 0}, {"sun", 3, 0},
+    {"omega", 3, 0}, {"quaternion", 4, 0}, {"psi", 2, 0}, {"dpsi", 2, 0},
+    {"position", 3, 0}, {"velocity", 3, 0},
+    {"frames", 1, 0}, {"frame", 1, 0}, {"steps", 1, 0}, {"orbitsteps", 1, 0},
+    {"every", 1, 0}, {"modes", 1, 0}, {"mode", 5, 0},
+    {"psimin", 2, 0}, {"psimax", 2, 0}, {"contacts", 1, 0}, {"contact", 4, 0},
+};
+
+static double * scenariotarget(Scenario & sc, int k)
+{
+    double * targets[] = {
+        sc.I1, sc.I2, sc.a1, sc.a2, sc.e1, sc.c, sc.sun,
+        &sc.y[0], &sc.y[3], &sc.y[7], &sc.y[9], &sc.orbit[0], &sc.orbit[3],
+    };
+    return targets[k];
+}
+
+/*************************************************************************
+  Круговая скорость для позиции sc.orbit[0..2]: модуль sqrt(M/r),
+  направление r x z (для позиции на полюсе - r x x), так что для
+  позиции по умолчанию это (sqrt(M/r), 0, 0). При нулевой позиции
+  возвращает 0.
+ *************************************************************************/
+static int scenariocircular(Scenario & sc)
+{
+    double * r = sc.orbit;
+    double len = sqrt(r[0]*r[0] + r[1]*r[1] + r[2]*r[2]);
+    if (!(len > 0.0))
+        return 0;
+
+    double d[3] = {r[1], -r[0], 0.0};
+    double dlen = sqrt(d[0]*d[0] + d[1]*d[1]);
+    if (dlen < 1e-9*len)
+    {
+        d[0] = 0.0;
+        d[1] = r[2];
+        d[2] = -r[1];
+        dlen = sqrt(d[1]*d[1] + d[2]*d[2]);
+    }
+
+    double speed = sqrt(M/len);
+    int i;
+    for (i=0;i<3;i++)
+        sc.orbit[3+i] = speed*d[i]/dlen;
+    return 1;
+}
+
+/*************************************************************************
+  Чтение файла сценария поверх sc (обычно после scenariodefault). Имя
+  сценария - имя файла без каталога и расширения, файл кадров по
+  умолчанию - <имя>.txt. При ошибке печатает файл и строку и
+  возвращает 0.
+ *************************************************************************/
+int scenarioload(const char * name, Scenario & sc)
+{
+    std::ifstream in(name);
+    if (!in)
+    {
+        std::cerr<<name<<": cannot open"<<std::endl;
+        return 0;
+    }
+
+    std::string base(name);
+    size_t slash = base.find_last_of("/\\");
+    if (slash != std::string::npos)
+        base = base.substr(slash + 1);
+    size_t dot = base.find_last_of('.');
+    if (dot != std::string::npos && dot > 0)
+        base = base.substr(0, dot);
+    sc.name = base;
+    sc.output = base + ".txt";
+
+    const int nkeys = sizeof(scenariokeys)/sizeof(scenariokeys[0]);
+    std::string line;
+    int lineno = 0;
+    int position = 0, velocity = 0;
+    while (std::getline(in, line))
+    {
+        lineno++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos)
+            line.erase(hash);
+
+        std::istringstream words(line);
+        std::string key;
+        if (!(words>>key))
+            continue;
+
+        if (key == "output")
+        {
+            if (!(words>>sc.output))
+            {
+                std::cerr<<name<<":"<<lineno<<": output needs a file name"<<std::endl;
+                return 0;
+            }
+            continue;
+        }
+
+        int k;
+        for (k=0;k<nkeys;k++)
+            if (key == scenariokeys[k].key)
+                break;
+        if (k == nkeys)
+        {
+            std::cerr<<name<<":"<<lineno<<": unknown key "<<key<<std::endl;
+            return 0;
+        }
+
+        std::vector<double> values;
+        double value;
+        while (words>>value)
+            values.push_back(value);
+        if (!words.eof())
+        {
+            std::cerr<<name<<":"<<lineno<<": bad number after "<<key<<std::endl;
+            return 0;
+        }
+
+        const ScenarioKey & sk = scenariokeys[k];
+        int n = (int)values.size();
+        if (n != sk.count && (sk.two == 0 || n != sk.two))
+        {
+            std::cerr<<name<<":"<<lineno<<": "<<key<<" needs "<<sk.count<<" numbers"<<std::endl;
+            return 0;
+        }
+
+        if (key == "frames")
+            sc.frames = (int)values[0];
+        else if (key == "frame")
+            sc.frame = values[0];
+        else if (key == "steps")
+            sc.steps = (int)values[0];
+        else if (key == "orbitsteps")
+            sc.orbitsteps = (int)values[0];
+        else if (key == "every")
+            sc.every = (int)values[0];
+        else if (key == "modes")
+        {
+            sc.modes = (int)values[0];
+            if (sc.modes < 0 || sc.modes > MAXMODES)
+            {
+                std::cerr<<name<<":"<<lineno<<": modes must be 0.."<<MAXMODES<<std::endl;
+                return 0;
+            }
+        }
+        else if (key == "mode")
+        {
+            int m = (int)values[0];
+            if (m < 1 || m > MAXMODES || values[3] <= 0 || values[4] < 0)
+            {
+                std::cerr<<name<<":"<<lineno<<": mode needs a number 1.."<<MAXMODES
+                         <<", beta, sigma, a positive frequency and damping"<<std::endl;
+                return 0;
+            }
+            sc.basis[m-1].beta = values[1];
+            sc.basis[m-1].sigma = values[2];
+            sc.basis[m-1].frequency = values[3];
+            sc.basis[m-1].damping = values[4];
+        }
+        else if (key == "psimin" || key == "psimax")
+        {
+            double * target = (key == "psimin") ? sc.psimin : sc.psimax;
+            target[0] = values[0];
+            target[1] = values[1];
+        }
+        else if (key == "contacts")
+        {
+            sc.contacts = (int)values[0];
+            if (sc.contacts < 0 || sc.contacts > MAXCONTACTS)
+            {
+                std::cerr<<name<<":"<<lineno<<": contacts must be 0.."<<MAXCONTACTS<<std::endl;
+                return 0;
+            }
+        }
+        else if (key == "contact")
+        {
+            int m = (int)values[0];
+            if (m < 1 || m > MAXCONTACTS)
+            {
+                std::cerr<<name<<":"<<lineno<<": contact needs a number 1.."<<MAXCONTACTS
+                         <<" and three coordinates"<<std::endl;
+                return 0;
+            }
+            int i;
+            for (i=0;i<3;i++)
+                sc.contact[m-1][i] = values[1+i];
+        }
+        else
+        {
+            if (key == "position")
+                position = 1;
+            else if (key == "velocity")
+                velocity = 1;
+
+            double * target = scenariotarget(sc, k);
+            int i;
+            if (n == sk.count)
+            {
+                for (i=0;i<n;i++)
+                    target[i] = values[i];
+            }
+            else
+            {
+                // Диагональный тензор
+                for (i=0;i<9;i++)
+                    target[i] = 0.0;
+                for (i=0;i<3;i++)
+                    target[4*i] = values[i];
+            }
+        }
+    }
+
+    if (sc.frames < 1 || sc.frame <= 0 || sc.steps < 1 || sc.orbitsteps < 1 || sc.every < 1)
+    {
+        std::cerr<<name<<": frames, frame, steps, orbitsteps and every must be positive"<<std::endl;
+        return 0;
+    }
+    if (!(sc.psimin[0] < sc.psimax[0]) || !(sc.psimin[1] < sc.psimax[1]))
+    {
+        std::cerr<<name<<": psimin must be below psimax"<<std::endl;
+        return 0;
+    }
+    if (position && !velocity && !scenariocircular(sc))
+    {
+        std::cerr<<name<<": position must be away from the Earth centre"<<std::endl;
+        return 0;
+    }
+    return 1;
+}
+
+/*************************************************************************
+  Параметры сценария - в глобальные I1, I2, a1, a2_, e1, c, sunvec и
+  базис упругих форм modes, начальные состояния - в y (упругие формы
+  обнуляются) и result.
+ *************************************************************************/
+void scenarioapply(const Scenario & sc, double * y, double * result)
+{
+    int i, j;
+    I1 = 0.0;
+    I2 = 0.0;
+    for (i=0;i<3;i++)
+    {
+        for (j=0;j<3;j++)
+        {
+            I1(i,j) = sc.I1[3*i+j];
+            I2(i,j) = sc.I2[3*i+j];
+        }
+    }
+
+    for (i=0;i<3;i++)
+    {
+        a1(i) = sc.a1[i];
+        a2_(i) = sc.a2[i];
+        e1(i) = sc.e1[i];
+        c(i) = sc.c[i];
+        sunvec[i] = sc.sun[i];
+    }
+    for (i=0;i<MAXMODES;i++)
+        modes[i] = sc.basis[i];
+
+    for (i=0;i<11;i++)
+        y[i] = sc.y[i];
+    for (i=11;i<11+2*MAXMODES;i++)
+        y[i] = 0.0;
+    for (i=0;i<6;i++)
+        result[i] = sc.orbit[i];
+}
+
+/*************************************************************************
+  Файлы сценариев по пути: сам файл или все *.scn каталога по алфавиту.
+  Возвращает 0, если путь не открывается.
+ *************************************************************************/
+int scenariolist(const char * path, std::vector<std::string> & files)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+    {
+        std::cerr<<path<<": not found"<<std::endl;
+        return 0;
+    }
+
+    if (!S_ISDIR(st.st_mode))
+    {
+        files.push_back(path);
+        return 1;
+    }
+
+    DIR * dir = opendir(path);
+    if (!dir)
+    {
+        std::cerr<<path<<": cannot open"<<std::endl;
+        return 0;
+    }
+
+    std::vector<std::string> found;
+    struct dirent * entry;
+    while ((entry = readdir(dir)) != 0)
+    {
+        std::string name(entry->d_name);
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".scn") == 0)
+            found.push_back(std::string(path) + "/" + name);
+    }
+    closedir(dir);
+
+    std::sort(found.begin(), found.end());
+    files.insert(files.end(), found.begin(), found.end());
+    return 1;
+}
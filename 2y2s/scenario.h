@@ -0,0 +1,83 @@
+#ifndef SCENARIO_H
+#define SCENARIO_H
+
+#include <string>
+#include <vector>
+
+#include "modal.h"
+#include "hingestop.h"
+
+/*************************************************************************
+  Сценарий прогона: параметры модели, начальное состояние и разбиение
+  по времени, которые раньше были константами main(). Файл сценария -
+  строки "ключ числа...", # - комментарий до конца строки, не указанные
+  ключи берутся из scenariodefault:
+
+      I1 38.57 29.05 33.96     тензор спутника: диагональ или 9 чисел
+      I2 5.549 1.757 7.304     тензор панели
+      a1 0 0.5 0               шарнир в системе спутника
+      a2 0 1 0                 центр панели от шарнира
+      e1 0 1 0                 ось первого шарнира
+      c 0 0.5 0.5              смещение камеры
+      sun 0 1.5e11 0           направление на Солнце
+      omega 0.001 0.001 0.001  угловая скорость
+      quaternion 1 0 0 0       ориентация (y[3..6])
+      psi 0 0                  углы панели
+      dpsi 0.001 0.001         скорости панели
+      position 0 6500000 0     орбита, м
+      velocity 7831 0 0        м/с; без ключа при заданной position -
+                               круговая для неё (sqrt(M/r) по r x z)
+      frames 150               число кадров
+      frame 10                 длительность кадра, с
+      steps 10                 шагов РК4 углового движения на кадр
+      orbitsteps 10            шагов РК4 орбиты на кадр
+      every 1                  в файл - каждый every-й кадр
+      output run1.txt          файл кадров
+      modes 3                  число упругих форм панели (-modal)
+      mode 1 1.875 0.734 0.05 0.005
+                               форма 1..4 базиса: beta, sigma, частота
+                               (Гц), демпфирование; по умолчанию -
+                               modalbasis
+      psimin -1.5 -1e9         упоры шарнира по углам панели (-stops),
+      psimax 1.5 1e9           1e9 - упора нет
+      contacts 4               число точек касания корпуса (-stops)
+      contact 1 -0.5 1 0.01    точка 1..4: вершина панели, как d1..d8;
+                               по умолчанию - d1, d3, d5, d7
+ *************************************************************************/
+struct Scenario
+{
+    std::string name;
+    std::string output;
+
+    double I1[9];
+    double I2[9];
+    double a1[3];
+    double a2[3];
+    double e1[3];
+    double c[3];
+    double sun[3];
+
+    double y[11];
+    double orbit[6];
+
+    int frames;
+    double frame;
+    int steps;
+    int orbitsteps;
+    int every;
+
+    int modes;
+    Mode basis[MAXMODES];
+
+    double psimin[2];
+    double psimax[2];
+    int contacts;
+    double contact[MAXCONTACTS][3];
+};
+
+void scenariodefault(Scenario & sc);
+int scenarioload(const char * name, Scenario & sc);
+void scenarioapply(const Scenario & sc, double * y, double * result);
+int scenariolist(const char * path, std::vector<std::string> & files);
+
+#endif // SCENARIO_H
@@ -0,0 +1,120 @@
+#include "detector.h"
+#include "srp.h"
+
+// Учитывать ли давление солнечного излучения на панель
+int srp = 0;
+
+// Доли зеркального и диффузного отражения освещённой грани,
+// остальное поглощается
+double srpspecular = 0.1;
+
+double srpdiffuse = 0.2;
+
+// Грань панели (в тех же координатах, что и вершины для Ansi):
+// центр, единичная нормаль и площадь
+static mtl::dense_vector <double> srpcenter(3, 0.0);
+static mtl::dense_vector <double> srpnormal(3, 0.0);
+static double srparea = 0.0;
+
+// Направление на Солнце (инерциальное, единичное) и давление с учётом
+// расстояния и доли видимого диска. На протяжении кадра не меняются,
+// так что на этапах Рунге-Кутты не пересчитываются. У каждого потока
+// свои: части Parareal идут в потоках, каждая со своим кадром
+static thread_local double srpdirection[3];
+static thread_local double srpp = 0.0;
+
+/*************************************************************************
+  Грань панели по трём вершинам: a - общая вершина двух рёбер a-b и
+  a-d. Центр грани (b+d)/2, нормаль и площадь - из векторного
+  произведения рёбер.
+ *************************************************************************/
+void srpface(mtl::dense_vector <double> a, mtl::dense_vector <double> b, mtl::dense_vector <double> d)
+{
+    using namespace mtl;
+
+    dense_vector <double> n(3);
+    n=cross(dense_vector <double>(b - a), dense_vector <double>(d - a));
+
+    srparea=two_norm(n);
+    srpnormal=n/srparea;
+    srpcenter=0.5*(b + d);
+}
+
+/*************************************************************************
+  Солнце на текущий кадр: sun и position - инерциальные положения
+  Солнца и спутника, fraction - видимая доля диска (освещённость).
+ *************************************************************************/
+void srpsun(const double * sun, const double * position, double fraction)
+{
+    int i;
+    for (i=0;i<3;i++)
+        srpdirection[i]=sun[i]-position[i];
+
+    double d=sqrt(srpdirection[0]*srpdirection[0] + srpdirection[1]*srpdirection[1]
+                + srpdirection[2]*srpdirection[2]);
+    for (i=0;i<3;i++)
+        srpdirection[i]/=d;
+
+    srpp=SRPPRESSURE*(AU/d)*(AU/d)*fraction;
+}
+
+/*************************************************************************
+  Обобщённые силы давления излучения для v(y): g[0..2] - момент
+  относительно начала связанной системы, g[3], g[4] - моменты по осям
+  шарниров. Сила на плоскую грань (s - на Солнце, n - нормаль
+  освещённой стороны, cos = n.s):
+
+      F = -p A cos ((1 - rs) s + 2 (rs cos + rd/3) n),
+
+  приложена в центре грани. Поворот панели B1^T B3^T и направление на
+  Солнце в связанной системе считаются один раз на вызов.
+ *************************************************************************/
+void srpforces(double * y, double * g)
+{
+    using namespace mtl;
+
+    int i;
+    for (i=0;i<5;i++)
+        g[i]=0.0;
+
+    if (srpp == 0.0 || srparea == 0.0)
+        return;
+
+    dense2D <double> P(3, 3);
+    P=trans(B1(y))*trans(B3(y));
+
+    dense_vector <double> sun(3);
+    for (i=0;i<3;i++)
+        sun(i)=srpdirection[i];
+
+    dense_vector <double> s(3);
+    s=Qmatrix(q(y))*sun;
+
+    dense_vector <double> n(3);
+    n=P*srpnormal;
+
+    double cs=dot(n, s);
+    if (cs < 0)
+    {
+        n*=-1.0;
+        cs=-cs;
+    }
+
+    dense_vector <double> F(3);
+    F=-srpp*srparea*cs*((1.0 - srpspecular)*s + 2.0*(srpspecular*cs + srpdiffuse/3.0)*n);
+
+    dense_vector <double> alpha(3);
+    alpha=P*dense_vector <double>(a2_ + srpcenter);
+
+    dense_vector <double> tau1(3);
+    tau1=cross(dense_vector <double>(a1 + alpha), F);
+
+    dense_vector <double> tau2(3);
+    tau2=cross(alpha, F);
+
+    for (i=0;i<3;i++)
+        g[i]=tau1(i);
+
+    g[3]=dot(tau2, e1);
+    g[4]=dot(tau2, dense_vector <double>(trans(B1(y))*e3(y)));
+}
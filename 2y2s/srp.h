@@ -0,0 +1,20 @@
+#ifndef SRP_H
+#define SRP_H
+
+#include <boost/numeric/mtl/mtl.hpp>
+
+// Давление солнечного излучения на 1 а.е. (Н/м^2) и сама а.е. (м)
+#define SRPPRESSURE 4.56e-6
+#define AU 149597870700.0
+
+extern int srp;
+
+extern double srpspecular;
+
+extern double srpdiffuse;
+
+void srpface(mtl::dense_vector <double> a, mtl::dense_vector <double> b, mtl::dense_vector <double> d);
+void srpsun(const double * sun, const double * position, double fraction);
+void srpforces(double * y, double * g);
+
+#endif // SRP_H
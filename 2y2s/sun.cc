@@ -0,0 +1,50 @@
+#include "detector.h"
+#include "sun.h"
+
+// Юлианская дата момента t=0 (по умолчанию J2000)
+double epochjd = 2451545.0;
+
+Chebyshev sunchebyshev;
+
+/*************************************************************************
+  Положение Солнца в геоцентрической экваториальной системе (м) через
+  t секунд после epochjd. Упрощённая аналитическая теория (Montenbruck,
+  Gill, "Satellite Orbits", 3.3.2), точность около 0.1-1 угловой
+  минуты - для тени и освещённости больше не нужно.
+ *************************************************************************/
+void sunposition(double t, double * s)
+{
+    double T = (epochjd - 2451545.0 + t/86400.0)/36525.0;
+
+    double deg = M_PI/180.0;
+
+    double Ms = (357.5256 + 35999.049*T)*deg;
+    double L = (282.9400 + 1.3972*T)*deg + Ms
+             + (6892.0*sin(Ms) + 72.0*sin(2.0*Ms))/3600.0*deg;
+    double r = (149.619 - 2.499*cos(Ms) - 0.021*cos(2.0*Ms))*1e9;
+
+    double eps = 23.43929111*deg;
+
+    s[0] = r*cos(L);
+    s[1] = r*sin(L)*cos(eps);
+    s[2] = r*sin(L)*sin(eps);
+}
+
+static void sunfunction(double t, double * out, void *)
+{
+    sunposition(t, out);
+}
+
+/*************************************************************************
+  Чебышёвская аппроксимация положения Солнца на [t0, t1]: сегменты по
+  суткам, 10 коэффициентов на координату. Ошибка - sunchebyshev.error.
+ *************************************************************************/
+void sunfit(double t0, double t1)
+{
+    chebfit(sunchebyshev, t0, t1, 86400.0, 10, 3, sunfunction, 0);
+}
+
+void sunat(double t, double * s)
+{
+    chebeval(sunchebyshev, t, s);
+}
@@ -0,0 +1,14 @@
+#ifndef SUN_H
+#define SUN_H
+
+#include "chebyshev.h"
+
+extern double epochjd;
+
+extern Chebyshev sunchebyshev;
+
+void sunposition(double t, double * s);
+void sunfit(double t0, double t1);
+void sunat(double t, double * s);
+
+#endif // SUN_H
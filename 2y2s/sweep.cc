@@ -0,0 +1,507 @@
+#include "detector.h"
+#include "sweep.h"
+#include "modal.h"
+#include "geopotential.h"
+#include "binfile.h"
+#include "runcache.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sstream>
+#include <chrono>
+#include <algorithm>
+#ifdef _WIN32
+#include <stdlib.h>
+#else
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+// Признаки файла части ("SWP2") и собранного результата ("SWR1")
+#define SWEEPSHARDMAGIC 0x32505753
+#define SWEEPMAGIC 0x31525753
+
+static int sweepaxis(const char * name, int lineno, std::istringstream & words, SweepAxis & axis)
+{
+    if (!(words>>axis.min>>axis.max>>axis.count) || axis.count < 1)
+    {
+        std::cerr<<name<<":"<<lineno<<": axis needs min, max and a positive count"<<std::endl;
+        return 0;
+    }
+    return 1;
+}
+
+/*************************************************************************
+  Чтение файла перебора. Путь базового сценария - относительно каталога
+  файла перебора. При ошибке печатает файл и строку и возвращает 0.
+ *************************************************************************/
+int sweepload(const char * name, Sweep & sw)
+{
+    sw.file = name;
+    scenariodefault(sw.base);
+    sw.inertia.min = sw.inertia.max = 1.0;
+    sw.inertia.count = 1;
+    sw.offset.min = sw.offset.max = sw.base.a1[1];
+    sw.offset.count = 1;
+    sw.push.min = sw.push.max = sw.base.y[9];
+    sw.push.count = 1;
+    sw.partition = 8;
+
+    std::ifstream in(name);
+    if (!in)
+    {
+        std::cerr<<name<<": cannot open"<<std::endl;
+        return 0;
+    }
+
+    std::string dir(name);
+    size_t slash = dir.find_last_of('/');
+    dir = (slash == std::string::npos) ? std::string() : dir.substr(0, slash + 1);
+
+    std::string line;
+    int lineno = 0;
+    while (std::getline(in, line))
+    {
+        lineno++;
+        size_t hash = line.find('#');
+        if (hash != std::string::npos)
+            line.erase(hash);
+
+        std::istringstream words(line);
+        std::string key;
+        if (!(words>>key))
+            continue;
+
+        if (key == "scenario")
+        {
+            std::string base;
+            if (!(words>>base))
+            {
+                std::cerr<<name<<":"<<lineno<<": scenario needs a file name"<<std::endl;
+                return 0;
+            }
+            if (base[0] != '/')
+                base = dir + base;
+            if (!scenarioload(base.c_str(), sw.base))
+                return 0;
+        }
+        else if (key == "inertia")
+        {
+            if (!sweepaxis(name, lineno, words, sw.inertia))
+                return 0;
+        }
+        else if (key == "offset")
+        {
+            if (!sweepaxis(name, lineno, words, sw.offset))
+                return 0;
+        }
+        else if (key == "push")
+        {
+            if (!sweepaxis(name, lineno, words, sw.push))
+                return 0;
+        }
+        else if (key == "partition")
+        {
+            if (!(words>>sw.partition) || sw.partition < 1)
+            {
+                std::cerr<<name<<":"<<lineno<<": partition needs a positive number"<<std::endl;
+                return 0;
+            }
+        }
+        else
+        {
+            std::cerr<<name<<":"<<lineno<<": unknown key "<<key<<std::endl;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+int sweeppoints(const Sweep & sw)
+{
+    return sw.inertia.count*sw.offset.count*sw.push.count;
+}
+
+static double sweepvalue(const SweepAxis & axis, int i)
+{
+    if (axis.count == 1)
+        return axis.min;
+    return axis.min + (axis.max - axis.min)*i/(axis.count - 1);
+}
+
+/*************************************************************************
+  Одна точка сетки: панель на шарнире (flag=1) на всех кадрах базового
+  сценария, как прогон detector без ключей. Строка - SWEEPCOLS чисел.
+ *************************************************************************/
+static void sweeppoint(const Sweep & sw, int index, double * row)
+{
+    int ip = index % sw.push.count;
+    int io = (index / sw.push.count) % sw.offset.count;
+    int ii = index / (sw.push.count*sw.offset.count);
+
+    Scenario sc = sw.base;
+    double scale = sweepvalue(sw.inertia, ii);
+    int i, j;
+    for (i=0;i<9;i++)
+        sc.I2[i] *= scale;
+    sc.a1[1] = sweepvalue(sw.offset, io);
+    sc.y[9] = sweepvalue(sw.push, ip);
+
+    double y[11+2*MAXMODES];
+    double result[6];
+    scenarioapply(sc, y, result);
+
+    double peak[4] = {0.0, 0.0, 0.0, 0.0};
+    for (j=0;j<sc.frames;j++)
+    {
+        // Гравитационный момент (-geopotential) - по положению на конце
+        // кадра, как в detectorrun
+        if (gravitygradient)
+        {
+            solvesystemrungekutta(6,sc.frame*j,sc.frame*(j+1),sc.orbitsteps,result, 0);
+            for (i=0;i<3;i++)
+                gravityposition[i]=result[i];
+        }
+        solvesystemrungekutta(11,0,sc.frame,sc.steps,y, 1);
+        for (i=0;i<4;i++)
+        {
+            if (fabs(y[7+i]) > peak[i])
+                peak[i] = fabs(y[7+i]);
+        }
+    }
+
+    row[0] = index;
+    row[1] = scale;
+    row[2] = sc.a1[1];
+    row[3] = sc.y[9];
+    for (i=0;i<4;i++)
+        row[4+i] = peak[i];
+    for (i=0;i<11;i++)
+        row[8+i] = y[i];
+}
+
+/*************************************************************************
+  Ключ перебора в файле части: ключ кэша базового сценария (runcachekey,
+  в нём и gravitygradient), число кадров, оси сетки и размер части.
+  Часть, оставшаяся от перебора с другим ключом, пересчитывается.
+ *************************************************************************/
+static void sweepkey(const Sweep & sw, std::vector<double> & key)
+{
+    runcachekey(sw.base, 11, key);
+    key.push_back(sw.base.frames);
+
+    const SweepAxis * axes[3] = {&sw.inertia, &sw.offset, &sw.push};
+    int i;
+    for (i=0;i<3;i++)
+    {
+        key.push_back(axes[i]->min == 0.0 ? 0.0 : axes[i]->min);
+        key.push_back(axes[i]->max == 0.0 ? 0.0 : axes[i]->max);
+        key.push_back(axes[i]->count);
+    }
+    key.push_back(sw.partition);
+    key.push_back(gravitygradient);
+}
+
+// Запись через filetemp и filereplace: файл части либо есть целиком,
+// либо его нет. key - ключ перебора (у собранного результата его нет)
+static int sweepwrite(const std::string & name, int magic, const int * header, int headersize,
+                      const std::vector<double> & key, const std::vector<double> & rows)
+{
+    std::string temp = filetemp(name);
+
+    std::ofstream out(temp.c_str(), std::ios::binary);
+    if (!out)
+        return 0;
+
+    out.write((const char *)&magic, sizeof(int));
+    out.write((const char *)header, headersize*sizeof(int));
+    out.write((const char *)key.data(), key.size()*sizeof(double));
+    out.write((const char *)rows.data(), rows.size()*sizeof(double));
+
+    return filereplace(out, temp, name);
+}
+
+/*************************************************************************
+  Исполнитель: точки [first, last) в файл части shard. Возвращает 0 -
+  код завершения процесса - или 1.
+ *************************************************************************/
+int sweepworker(const Sweep & sw, int first, int last, const char * shard)
+{
+    if (first < 0 || last > sweeppoints(sw) || first >= last)
+    {
+        std::cerr<<shard<<": bad partition "<<first<<" "<<last<<std::endl;
+        return 1;
+    }
+
+    std::vector<double> rows((last - first)*SWEEPCOLS);
+    int k;
+    for (k=first;k<last;k++)
+        sweeppoint(sw, k, &rows[(k - first)*SWEEPCOLS]);
+
+    std::vector<double> key;
+    sweepkey(sw, key);
+    int header[4] = {first, last, SWEEPCOLS, (int)key.size()};
+    if (!sweepwrite(shard, SWEEPSHARDMAGIC, header, 4, key, rows))
+    {
+        std::cerr<<shard<<": cannot write"<<std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// Файл части целиком, ровно для точек [first, last) и с ключом key
+static int sweepshard(const std::string & name, const std::vector<double> & key, int first, int last,
+                      std::vector<double> & rows)
+{
+    std::ifstream in(name.c_str(), std::ios::binary);
+    if (!in)
+        return 0;
+
+    int header[5] = {0, 0, 0, 0, 0};
+    in.read((char *)header, sizeof(header));
+    if (!in || header[0] != SWEEPSHARDMAGIC || header[1] != first || header[2] != last
+        || header[3] != SWEEPCOLS || header[4] != (int)key.size())
+        return 0;
+
+    std::vector<double> filekey(key.size());
+    in.read((char *)filekey.data(), filekey.size()*sizeof(double));
+    if (!in || memcmp(filekey.data(), key.data(), key.size()*sizeof(double)) != 0)
+        return 0;
+
+    rows.resize((last - first)*SWEEPCOLS);
+    in.read((char *)rows.data(), rows.size()*sizeof(double));
+    if (!in || in.peek() != EOF)
+        return 0;
+
+    int k;
+    for (k=first;k<last;k++)
+    {
+        if (rows[(k - first)*SWEEPCOLS] != k)
+            return 0;
+    }
+    return 1;
+}
+
+#ifdef _WIN32
+/*************************************************************************
+  Без fork (MinGW): задача выполняется сразу - в этом процессе или
+  через system(), - а её номер и код завершения ждут sweepwait. Части
+  тогда идут по одной.
+ *************************************************************************/
+static std::vector< std::pair<pid_t, int> > sweepfinished;
+static pid_t sweeplast = 0;
+
+static pid_t sweepdone(int code)
+{
+    sweepfinished.push_back(std::make_pair(++sweeplast, code));
+    return sweeplast;
+}
+#endif
+
+// Завершившаяся задача: номер или -1, ok - код завершения 0
+static pid_t sweepwait(int & ok)
+{
+#ifdef _WIN32
+    if (sweepfinished.empty())
+        return -1;
+    pid_t pid = sweepfinished.front().first;
+    ok = sweepfinished.front().second == 0;
+    sweepfinished.erase(sweepfinished.begin());
+    return pid;
+#else
+    int status = 0;
+    pid_t pid = waitpid(-1, &status, 0);
+    ok = WIFEXITED(status) && WEXITSTATUS(status) == 0;
+    return pid;
+#endif
+}
+
+pid_t sweepfork(const SweepLauncher &, const Sweep & sw, const SweepTask & task)
+{
+    std::cout.flush();
+    std::cerr.flush();
+#ifdef _WIN32
+    return sweepdone(sweepworker(sw, task.first, task.last, task.shard.c_str()));
+#else
+    pid_t pid = fork();
+    if (pid == 0)
+        _exit(sweepworker(sw, task.first, task.last, task.shard.c_str()));
+    return pid;
+#endif
+}
+
+pid_t sweepcommand(const SweepLauncher & launcher, const Sweep & sw, const SweepTask & task)
+{
+    std::ostringstream args;
+    args<<"-sweepworker '"<<sw.file<<"' "<<task.first<<" "<<task.last<<" '"<<task.shard<<"'";
+    if (gravitygradient)
+        args<<" -geopotential";
+
+    std::string command(launcher.command);
+    size_t at;
+    while ((at = command.find("%w")) != std::string::npos)
+        command.replace(at, 2, args.str());
+
+    std::cout.flush();
+    std::cerr.flush();
+#ifdef _WIN32
+    return sweepdone(system(command.c_str()));
+#else
+    pid_t pid = fork();
+    if (pid == 0)
+    {
+        execl("/bin/sh", "sh", "-c", command.c_str(), (char *)0);
+        _exit(127);
+    }
+    return pid;
+#endif
+}
+
+/*************************************************************************
+  Перебор: точки делятся на части по sw.partition, не более workers
+  частей выполняются одновременно, каждая - в своём процессе со своим
+  файлом <dir>/sweep.<часть>.shard. Часть, процесс которой завершился
+  с ошибкой или не оставил целого файла, ставится в очередь снова (до
+  SWEEPRETRIES раз). Части, файлы которых уже есть от прерванного
+  перебора с тем же ключом (sweepkey), не пересчитываются. В конце части собираются в
+  <dir>/sweep.bin - строки по номерам точек. Возвращает 0 или 1.
+ *************************************************************************/
+int sweeprun(const Sweep & sw, const SweepLauncher & launcher, int workers, const std::string & dir)
+{
+    auto t0 = std::chrono::steady_clock::now();
+
+    int points = sweeppoints(sw);
+    int parts = (points + sw.partition - 1)/sw.partition;
+    std::vector<SweepTask> tasks(parts);
+    std::vector<int> attempts(parts, 0);
+    std::vector<int> queue;
+    std::vector<double> rows;
+    std::vector<double> key;
+    sweepkey(sw, key);
+    int k;
+    for (k=0;k<parts;k++)
+    {
+        SweepTask & task = tasks[k];
+        task.part = k;
+        task.first = k*sw.partition;
+        task.last = std::min(points, task.first + sw.partition);
+        std::ostringstream shard;
+        shard<<dir<<"/sweep."<<k<<".shard";
+        task.shard = shard.str();
+
+        if (!sweepshard(task.shard, key, task.first, task.last, rows))
+            queue.push_back(k);
+    }
+    std::cout<<"SWEEP "<<points<<" POINTS IN "<<parts<<" PARTITIONS, "
+        <<parts - (int)queue.size()<<" ALREADY DONE"<<std::endl;
+
+    // Очередь - с конца, чтобы части шли по порядку
+    std::reverse(queue.begin(), queue.end());
+
+    std::vector<pid_t> running(parts, 0);
+    int active = 0;
+    int retries = 0;
+    int lost = 0;
+    while (!queue.empty() || active > 0)
+    {
+        while (!queue.empty() && active < workers)
+        {
+            k = queue.back();
+            queue.pop_back();
+            attempts[k]++;
+            pid_t pid = launcher.start(launcher, sw, tasks[k]);
+            if (pid < 0)
+            {
+                std::cerr<<tasks[k].shard<<": cannot start worker"<<std::endl;
+                lost++;
+                continue;
+            }
+            running[k] = pid;
+            active++;
+        }
+        if (active == 0)
+            break;
+
+        int ok = 0;
+        pid_t pid = sweepwait(ok);
+        if (pid < 0)
+            break;
+        for (k=0;k<parts;k++)
+            if (running[k] == pid)
+                break;
+        if (k == parts)
+            continue;
+        running[k] = 0;
+        active--;
+
+        if (ok && sweepshard(tasks[k].shard, key, tasks[k].first, tasks[k].last, rows))
+            continue;
+
+        if (attempts[k] < SWEEPRETRIES)
+        {
+            std::cout<<"SWEEP PARTITION "<<k<<" FAILED, RETRY"<<std::endl;
+            queue.push_back(k);
+            retries++;
+        }
+        else
+        {
+            std::cerr<<tasks[k].shard<<": worker failed "<<attempts[k]<<" times"<<std::endl;
+            lost++;
+        }
+    }
+
+    if (lost)
+    {
+        std::cout<<"SWEEP "<<lost<<" PARTITIONS LOST"<<std::endl;
+        return 1;
+    }
+
+    // Сборка: строка точки k - на месте k
+    std::vector<double> all(points*SWEEPCOLS);
+    for (k=0;k<parts;k++)
+    {
+        if (!sweepshard(tasks[k].shard, key, tasks[k].first, tasks[k].last, rows))
+        {
+            std::cerr<<tasks[k].shard<<": damaged"<<std::endl;
+            return 1;
+        }
+        std::copy(rows.begin(), rows.end(), all.begin() + tasks[k].first*SWEEPCOLS);
+    }
+
+    std::string name = dir + "/sweep.bin";
+    int header[5] = {sw.inertia.count, sw.offset.count, sw.push.count, points, SWEEPCOLS};
+    if (!sweepwrite(name, SWEEPMAGIC, header, 5, std::vector<double>(), all))
+    {
+        std::cerr<<name<<": cannot write"<<std::endl;
+        return 1;
+    }
+    for (k=0;k<parts;k++)
+        remove(tasks[k].shard.c_str());
+
+    auto t1 = std::chrono::steady_clock::now();
+    std::cout<<"SWEEP "<<points<<" POINTS, "<<retries<<" RETRIES IN "
+        <<std::chrono::duration<double>(t1 - t0).count()<<" s -> "<<name<<std::endl;
+    return 0;
+}
+
+/*************************************************************************
+  Чтение собранного результата: points*SWEEPCOLS чисел в rows. Возвращает
+  число точек, 0 - если файл не открылся или испорчен.
+ *************************************************************************/
+int sweepread(const char * name, std::vector<double> & rows)
+{
+    std::ifstream in(name, std::ios::binary);
+    if (!in)
+        return 0;
+
+    int header[6] = {0, 0, 0, 0, 0, 0};
+    in.read((char *)header, sizeof(header));
+    if (!in || header[0] != SWEEPMAGIC || header[4] < 1 || header[5] != SWEEPCOLS
+        || header[4] != header[1]*header[2]*header[3]
+        || (long long)header[4]*SWEEPCOLS*(long long)sizeof(double) != fileremaining(in))
+        return 0;
+
+    rows.resize(header[4]*SWEEPCOLS);
+    in.read((char *)rows.data(), rows.size()*sizeof(double));
+    return in.good() ? header[4] : 0;
+}
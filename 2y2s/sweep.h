@@ -0,0 +1,84 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+#include "scenario.h"
+
+// Столбцы строки результата: номер точки, множитель тензора панели,
+// смещение шарнира, начальная скорость шарнира, наибольшие |psi| и
+// |dpsi| по двум углам, конечное состояние y[0..10]
+#define SWEEPCOLS 19
+
+// Сколько раз перезапускать часть, на которой процесс упал
+#define SWEEPRETRIES 3
+
+// Ось сетки: count точек от min до max включительно
+struct SweepAxis
+{
+    double min;
+    double max;
+    int count;
+};
+
+/*************************************************************************
+  Перебор параметров: базовый сценарий и сетка по трём осям. Файл - как
+  у сценариев, строки "ключ числа...":
+
+      scenario main.scn     базовый сценарий (по умолчанию - scenariodefault)
+      inertia 0.5 2 4       множитель тензора панели I2: от, до, точек
+      offset 0.3 0.7 3      смещение шарнира a1[1], м
+      push 0 0.01 5         начальная скорость первого шарнира dpsi[0]
+      partition 8           точек в одной части (задаче процесса)
+
+  Номер точки - (inertia*offset.count + offset)*push.count + push.
+ *************************************************************************/
+struct Sweep
+{
+    std::string file;
+    Scenario base;
+    SweepAxis inertia;
+    SweepAxis offset;
+    SweepAxis push;
+    int partition;
+};
+
+// Задача процесса: точки [first, last) в файл shard
+struct SweepTask
+{
+    int part;
+    int first;
+    int last;
+    std::string shard;
+};
+
+/*************************************************************************
+  Запуск задачи на исполнителе. Возвращает pid процесса этой машины,
+  завершение которого означает конец задачи, или -1. sweepfork - сам
+  процесс через fork (замена для проверки без сети), sweepcommand -
+  команда command через /bin/sh, в которой %w заменяется на
+  "-sweepworker <файл> <first> <last> <shard>" (и -geopotential, если
+  он задан): например, "ssh node1 cd /work && ./2y2s %w". Файл
+  перебора и каталог частей должны быть видны исполнителю по тем же
+  путям. В Windows fork нет: sweepfork выполняет задачу в этом
+  процессе, sweepcommand - через system(), обе до возврата, и части
+  идут по одной.
+ *************************************************************************/
+struct SweepLauncher
+{
+    pid_t (*start)(const SweepLauncher & launcher, const Sweep & sw, const SweepTask & task);
+    const char * command;
+};
+
+pid_t sweepfork(const SweepLauncher & launcher, const Sweep & sw, const SweepTask & task);
+pid_t sweepcommand(const SweepLauncher & launcher, const Sweep & sw, const SweepTask & task);
+
+int sweepload(const char * name, Sweep & sw);
+int sweeppoints(const Sweep & sw);
+int sweepworker(const Sweep & sw, int first, int last, const char * shard);
+int sweeprun(const Sweep & sw, const SweepLauncher & launcher, int workers, const std::string & dir);
+int sweepread(const char * name, std::vector<double> & rows);
+
+#endif // SWEEP_H
@@ -0,0 +1,102 @@
+#include "trace.h"
+
+#ifdef ENABLE_TRACE
+
+#include <fstream>
+#include <mutex>
+#include <vector>
+
+// Событие: зона (phase 'X', начало и длительность в мкс) или значение
+// счётчика (phase 'C')
+struct TraceEvent
+{
+    const char * name;
+    char phase;
+    double ts;
+    double value;
+};
+
+// Буфер своего потока: пишется без блокировок, в общий список
+// заносится один раз при первом событии потока. Буферы не удаляются,
+// так что события завершившихся потоков тоже попадают в файл
+struct TraceBuffer
+{
+    int tid;
+    std::vector<TraceEvent> events;
+};
+
+static std::mutex tracemutex;
+static std::vector<TraceBuffer *> tracebuffers;
+static thread_local TraceBuffer * tracelocal = 0;
+
+static const std::chrono::steady_clock::time_point traceorigin = std::chrono::steady_clock::now();
+
+static TraceBuffer * tracebuffer()
+{
+    if (!tracelocal)
+    {
+        tracelocal = new TraceBuffer;
+        tracelocal->events.reserve(1 << 16);
+
+        std::lock_guard<std::mutex> lock(tracemutex);
+        tracelocal->tid = (int)tracebuffers.size();
+        tracebuffers.push_back(tracelocal);
+    }
+    return tracelocal;
+}
+
+// Время в мкс от начала программы
+double tracenow()
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - traceorigin).count();
+}
+
+void tracezone(const char * name, double start, double end)
+{
+    TraceEvent e = {name, 'X', start, end - start};
+    tracebuffer()->events.push_back(e);
+}
+
+void tracecounter(const char * name, double value)
+{
+    TraceEvent e = {name, 'C', tracenow(), value};
+    tracebuffer()->events.push_back(e);
+}
+
+/*************************************************************************
+  Запись всех буферов в JSON. Вызывать, когда остальные потоки не пишут
+  события (после join), - буферы читаются без блокировки.
+ *************************************************************************/
+void tracesave(const char * filename)
+{
+    std::lock_guard<std::mutex> lock(tracemutex);
+
+    std::ofstream out(filename);
+    out.precision(15);
+    out<<"{\"traceEvents\":["<<std::endl;
+
+    bool first = true;
+    size_t b, i;
+    for (b=0;b<tracebuffers.size();b++)
+    {
+        TraceBuffer * buffer = tracebuffers[b];
+        for (i=0;i<buffer->events.size();i++)
+        {
+            const TraceEvent & e = buffer->events[i];
+            if (!first)
+                out<<","<<std::endl;
+            first = false;
+
+            out<<"{\"name\":\""<<e.name<<"\",\"ph\":\""<<e.phase<<"\",\"ts\":"<<e.ts
+               <<",\"pid\":1,\"tid\":"<<buffer->tid;
+            if (e.phase == 'X')
+                out<<",\"dur\":"<<e.value<<"}";
+            else
+                out<<",\"args\":{\"value\":"<<e.value<<"}}";
+        }
+    }
+
+    out<<std::endl<<"]}"<<std::endl;
+}
+
+#endif // ENABLE_TRACE
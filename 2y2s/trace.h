@@ -0,0 +1,52 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+/*************************************************************************
+  Трассировка по зонам для детектора и MapCreator. Включается при сборке
+  определением ENABLE_TRACE (DEFINES += ENABLE_TRACE в .pro), иначе все
+  макросы пустые и в код ничего не попадает.
+
+      TRACE_ZONE("name");           - зона до конца блока
+      TRACE_COUNTER("name", value); - значение счётчика в этот момент
+      TRACE_SAVE("file.json");      - записать всё в формате Chrome
+                                      trace events (chrome://tracing,
+                                      ui.perfetto.dev)
+
+  Имена - строковые литералы (хранится только указатель).
+ *************************************************************************/
+
+#ifdef ENABLE_TRACE
+
+#include <chrono>
+
+double tracenow();
+void tracezone(const char * name, double start, double end);
+void tracecounter(const char * name, double value);
+void tracesave(const char * filename);
+
+class TraceZone
+{
+public:
+    TraceZone(const char * name) : m_name(name), m_start(tracenow()) {}
+    ~TraceZone() { tracezone(m_name, m_start, tracenow()); }
+
+private:
+    const char * m_name;
+    double m_start;
+};
+
+#define TRACE_CAT2(a, b) a##b
+#define TRACE_CAT(a, b) TRACE_CAT2(a, b)
+#define TRACE_ZONE(name) TraceZone TRACE_CAT(tracezone_, __LINE__)(name)
+#define TRACE_COUNTER(name, value) tracecounter(name, value)
+#define TRACE_SAVE(filename) tracesave(filename)
+
+#else
+
+#define TRACE_ZONE(name)
+#define TRACE_COUNTER(name, value)
+#define TRACE_SAVE(filename)
+
+#endif // ENABLE_TRACE
+
+#endif // TRACE_H
@@ -4,9 +4,16 @@
 #include <iostream>
 #include <cmath>
 #include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "screening.h"
 
 #define M 1
 #define R 1
+// Радиус Солнца и расстояние до него в радиусах Земли
+#define RS 109.2
+#define AU 23455.0
 using namespace std;
 /*
 double fw1(double x, double * y);
@@ -24,9 +31,9 @@ double f(int i, double x, double * y){
 		case 0: return y[3];break;
 		case 1: return y[4];break;
 		case 2: return y[5];break;
-		case 3: return (-M*y[0])/pow(pow(y[0],2)+pow(y[1],2)+pow(y[2],2),3);break;
-		case 4: return (-M*y[1])/pow(pow(y[0],2)+pow(y[1],2)+pow(y[2],2),3);break;
-		case 5: return (-M*y[2])/pow(pow(y[0],2)+pow(y[1],2)+pow(y[2],2),3);break;
+		case 3: return (-M*y[0])/pow(pow(y[0],2)+pow(y[1],2)+pow(y[2],2),1.5);break;
+		case 4: return (-M*y[1])/pow(pow(y[0],2)+pow(y[1],2)+pow(y[2],2),1.5);break;
+		case 5: return (-M*y[2])/pow(pow(y[0],2)+pow(y[1],2)+pow(y[2],2),1.5);break;
 		default : break;
 	}
 }
@@ -110,7 +117,7 @@ void step(int n,double x,double h,double * y, double(f)(int i, double x, double
 	{
 		y[i] = y[i]+(k1[i]+2.0*k2[i]+2.0*k3[i]+k4[i])/6;
 	}
-	if (flag = 1)
+	if (flag == 1)
 	{
 		double modul = sqrt(y[3]*y[3]+y[4]*y[4]+y[5]*y[5]+y[6]*y[6]);
 		for(i = 3; i < 7; i++)
@@ -130,7 +137,7 @@ void step(int n,double x,double h,double * y, double(f)(int i, double x, double
 
   Результат помещается в переменную result[4]
  *************************************************************************/
-void solvesystemrungekutta(int n,double x,double x1,int steps,double * result, double (f)(int x, double x, double * y)){
+void solvesystemrungekutta(int n,double x,double x1,int steps,double * result, double (f)(int i, double x, double * y)){
 
 	for(int i = 0; i < steps; i++)
 	{
@@ -142,9 +149,94 @@ double dist_pl(double sunvec[3], double result[6]){
 	return sqrt(pow((sunvec[1]*result[0]-sunvec[0]*result[1]),2)+pow((sunvec[2]*result[1]-sunvec[1]*result[2]),2)+pow((sunvec[0]*result[2]-sunvec[2]*result[0]),2))/sqrt(sunvec[2]*sunvec[2]+sunvec[1]*sunvec[1]+sunvec[0]*sunvec[0]);
 };
 
-int main(){
+/*************************************************************************
+  Коническая модель тени: видимая доля солнечного диска.
+  sunvec - направление солнечных лучей (как в проверке на тень ниже),
+  Солнце находится в точке -AU*sunvec/|sunvec|.
+ *************************************************************************/
+double illumination(double sunvec[3], double result[6]){
+	double sn = sqrt(sunvec[0]*sunvec[0]+sunvec[1]*sunvec[1]+sunvec[2]*sunvec[2]);
+	double d[3];
+	for(int i = 0; i < 3; i++)
+		d[i] = -AU*sunvec[i]/sn - result[i];
+
+	double rn = sqrt(result[0]*result[0]+result[1]*result[1]+result[2]*result[2]);
+	double dn = sqrt(d[0]*d[0]+d[1]*d[1]+d[2]*d[2]);
+
+	double as = asin(RS/dn);
+	double ae = asin(R/rn < 1 ? R/rn : 1);
+	double cc = acos(-(d[0]*result[0]+d[1]*result[1]+d[2]*result[2])/(dn*rn));
+
+	if (cc >= as + ae)
+		return 1;
+	if (cc <= ae - as)
+		return 0;
+	if (cc <= as - ae)
+		return 1 - (ae*ae)/(as*as);
+
+	double x = (cc*cc + as*as - ae*ae)/(2*cc);
+	double y = sqrt(as*as - x*x);
+	double area = as*as*acos(x/as) + ae*ae*acos((cc - x)/ae) - cc*y;
+	return 1 - area/(M_PI*as*as);
+}
+
+/*************************************************************************
+  Проверка screening по Рунге-Кутте: count случайных орбит интегрируются
+  до каждого из nq моментов. Вне полутени (доля 0 или 1) флаг "центр
+  диска закрыт" обязан совпасть с illumination.
+ *************************************************************************/
+void screeningcheck(int count, int nq){
+	std::vector<double> x(count), y(count), z(count), vx(count), vy(count), vz(count);
+	std::vector<double> t(nq);
+	double sunvec[3] = {0, -1, 0};
+
+	srand(2);
+	for(int i = 0; i < count; i++){
+		double rp = 1.05 + 2.0*rand()/(double)RAND_MAX;
+		double e = 0.3*rand()/(double)RAND_MAX;
+		double inc = M_PI*rand()/(double)RAND_MAX;
+		double vp = sqrt(M*(1 + e)/rp);
+		x[i] = rp; y[i] = 0; z[i] = 0;
+		vx[i] = 0; vy[i] = vp*cos(inc); vz[i] = vp*sin(inc);
+	}
+	for(int j = 0; j < nq; j++)
+		t[j] = 20.0*j/nq;
+
+	std::vector<uint64_t> flags((size_t)count*SCREENWORDS(nq));
+	screening(count, &x[0], &y[0], &z[0], &vx[0], &vy[0], &vz[0], nq, &t[0], sunvec, &flags[0], 1);
+
+	int checked = 0, wrong = 0;
+	for(int i = 0; i < count; i++){
+		double result[6] = {x[i], y[i], z[i], vx[i], vy[i], vz[i]};
+		double x0 = 0;
+		for(int j = 0; j < nq; j++){
+			solvesystemrungekutta(6, x0, t[j], 200, result, f);
+			x0 = t[j];
+
+			double frac = illumination(sunvec, result);
+			if(frac > 0 && frac < 1)
+				continue;
+			checked++;
+			if(screenflag(&flags[0], nq, i, j) != (frac == 0))
+				wrong++;
+		}
+	}
+	cout<<"CHECKED "<<checked<<" MISMATCHES "<<wrong<<endl;
+}
+
+int main(int argc, char ** argv){
 	double result[6];
 	double sunvec[3];
+
+	// Пакетная проверка каталога: -batch [орбит] [моментов] [потоков]
+	if(argc > 1 && strcmp(argv[1], "-batch") == 0){
+		int count = (argc > 2) ? atoi(argv[2]) : 10000;
+		int nq = (argc > 3) ? atoi(argv[3]) : 1000;
+		int threads = (argc > 4) ? atoi(argv[4]) : 4;
+		screeningcheck(20, 500);
+		screeningbenchmark(count, nq, threads);
+		return 0;
+	}
 	
 //Задаём направление на Солнце
 	sunvec[0] = 0;
@@ -162,8 +254,11 @@ int main(){
 		cout<<result[i]<<endl;
 	}
 
-	if((dist_pl(sunvec, result) < R)&&((sunvec[0]*result[0]+sunvec[1]*result[1]+sunvec[2]*result[2]) > 0))
+	double frac = illumination(sunvec, result);
+	if(frac == 0)
 		cout<<"SHADOW"<<endl;
+	else if(frac < 1)
+		cout<<"PENUMBRA "<<frac<<endl;
 	else
 		cout<<"BRIGHT SIDE"<<endl;
 	return 0;
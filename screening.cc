@@ -0,0 +1,283 @@
+#include <math.h>
+#include <stdlib.h>
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <chrono>
+
+#include "screening.h"
+
+// Те же единицы, что и в detector.cc: радиус Земли и гравитационный
+// параметр равны 1, расстояние до Солнца в радиусах Земли
+#define M 1
+#define R 1
+#define AU 23455.0
+
+#define SCREENPI 3.14159265358979323846
+
+/*************************************************************************
+  Синус без вызова libm, чтобы цикл по моментам времени векторизовался:
+  приведение к [-pi, pi] через целую часть, отражение в [-pi/2, pi/2] и
+  ряд Тейлора до x^15 (ошибка меньше 1e-11).
+ *************************************************************************/
+static inline double screensin(double x)
+{
+	double k = (double)(int)(x*(0.5/SCREENPI) + copysign(0.5, x));
+	x -= k*(2.0*SCREENPI);
+
+	double ax = fabs(x);
+	x = (ax > 0.5*SCREENPI) ? copysign(SCREENPI, x) - x : x;
+
+	double x2 = x*x;
+	double p = -1.0/1307674368000.0;
+	p = p*x2 + 1.0/6227020800.0;
+	p = p*x2 - 1.0/39916800.0;
+	p = p*x2 + 1.0/362880.0;
+	p = p*x2 - 1.0/5040.0;
+	p = p*x2 + 1.0/120.0;
+	p = p*x2 - 1.0/6.0;
+	p = p*x2 + 1.0;
+	return x*p;
+}
+
+static inline double screencos(double x)
+{
+	return screensin(x + 0.5*SCREENPI);
+}
+
+/*************************************************************************
+  Элементы орбит каталога - структура массивов: большая полуось a,
+  эксцентриситет e, среднее движение n, средняя аномалия в момент 0 M0,
+  малая полуось b и единичные векторы P (на перицентр) и Q.
+ *************************************************************************/
+struct ScreenElements
+{
+	std::vector<double> a, e, n, M0, b;
+	std::vector<double> Px, Py, Pz, Qx, Qy, Qz;
+	std::vector<int> valid;
+};
+
+static void screenelements(int count, const double * x, const double * y, const double * z,
+	const double * vx, const double * vy, const double * vz, ScreenElements & el)
+{
+	el.a.resize(count); el.e.resize(count); el.n.resize(count);
+	el.M0.resize(count); el.b.resize(count);
+	el.Px.resize(count); el.Py.resize(count); el.Pz.resize(count);
+	el.Qx.resize(count); el.Qy.resize(count); el.Qz.resize(count);
+	el.valid.resize(count);
+
+	for (int i = 0; i < count; i++)
+	{
+		double r[3] = {x[i], y[i], z[i]};
+		double v[3] = {vx[i], vy[i], vz[i]};
+		double rn = sqrt(r[0]*r[0] + r[1]*r[1] + r[2]*r[2]);
+		double v2 = v[0]*v[0] + v[1]*v[1] + v[2]*v[2];
+		double rv = r[0]*v[0] + r[1]*v[1] + r[2]*v[2];
+
+		double h[3] = {r[1]*v[2] - r[2]*v[1], r[2]*v[0] - r[0]*v[2], r[0]*v[1] - r[1]*v[0]};
+		double hn = sqrt(h[0]*h[0] + h[1]*h[1] + h[2]*h[2]);
+
+		double a = 1.0/(2.0/rn - v2/M);
+		el.valid[i] = (a > 0 && hn > 0) ? 1 : 0;
+		if (!el.valid[i])
+			continue;
+
+		double ev[3];
+		for (int k = 0; k < 3; k++)
+			ev[k] = ((v2 - M/rn)*r[k] - rv*v[k])/M;
+		double e = sqrt(ev[0]*ev[0] + ev[1]*ev[1] + ev[2]*ev[2]);
+
+		double P[3];
+		double M0;
+		if (e < 1e-10)
+		{
+			// Круговая орбита: отсчёт от начального положения
+			e = 0;
+			for (int k = 0; k < 3; k++)
+				P[k] = r[k]/rn;
+			M0 = 0;
+		}
+		else
+		{
+			for (int k = 0; k < 3; k++)
+				P[k] = ev[k]/e;
+			double E0 = atan2(rv/sqrt(M*a), 1.0 - rn/a);
+			M0 = E0 - e*sin(E0);
+		}
+
+		el.a[i] = a;
+		el.e[i] = e;
+		el.n[i] = sqrt(M/(a*a*a));
+		el.M0[i] = M0;
+		el.b[i] = a*sqrt(1.0 - e*e);
+		el.Px[i] = P[0];
+		el.Py[i] = P[1];
+		el.Pz[i] = P[2];
+		el.Qx[i] = (h[1]*P[2] - h[2]*P[1])/hn;
+		el.Qy[i] = (h[2]*P[0] - h[0]*P[2])/hn;
+		el.Qz[i] = (h[0]*P[1] - h[1]*P[0])/hn;
+	}
+}
+
+/*************************************************************************
+  Флаги тени для орбит [first, last): положение по уравнению Кеплера
+  (6 итераций Ньютона без ветвлений), тень - центр солнечного диска
+  закрыт Землёй. Для d - на Солнце, r - от центра Земли, s = -(d.r):
+
+      s > 0  и  s^2 > |d|^2 (|r|^2 - R^2)
+
+  - угол между направлениями на Солнце и на центр Земли меньше
+  углового радиуса Земли, без корней и арккосинусов. Внутренний цикл
+  идёт по 64 моментам времени (одно слово флагов) и векторизуется.
+ *************************************************************************/
+static void screenrange(const ScreenElements & el, int first, int last,
+	int nq, const double * t, const double * S, uint64_t * flags)
+{
+	int words = SCREENWORDS(nq);
+	double bits[64];
+
+	for (int i = first; i < last; i++)
+	{
+		uint64_t * row = flags + (size_t)i*words;
+		if (!el.valid[i])
+		{
+			for (int w = 0; w < words; w++)
+				row[w] = 0;
+			continue;
+		}
+
+		double a = el.a[i], e = el.e[i], n = el.n[i], M0 = el.M0[i], b = el.b[i];
+		double Px = el.Px[i], Py = el.Py[i], Pz = el.Pz[i];
+		double Qx = el.Qx[i], Qy = el.Qy[i], Qz = el.Qz[i];
+
+		for (int w = 0; w < words; w++)
+		{
+			int j0 = w*64;
+			int m = (nq - j0 < 64) ? nq - j0 : 64;
+
+#pragma omp simd
+			for (int j = 0; j < m; j++)
+			{
+				double Mq = M0 + n*t[j0 + j];
+				double E = Mq + e*screensin(Mq);
+#pragma GCC unroll 6
+				for (int it = 0; it < 6; it++)
+					E -= (E - e*screensin(E) - Mq)/(1.0 - e*screencos(E));
+
+				double u = a*(screencos(E) - e);
+				double v = b*screensin(E);
+				double rx = u*Px + v*Qx;
+				double ry = u*Py + v*Qy;
+				double rz = u*Pz + v*Qz;
+
+				double dx = S[0] - rx, dy = S[1] - ry, dz = S[2] - rz;
+				double s = -(dx*rx + dy*ry + dz*rz);
+				double dd = dx*dx + dy*dy + dz*dz;
+				double rr = rx*rx + ry*ry + rz*rz;
+
+				bits[j] = (s > 0 && s*s > dd*(rr - R*R)) ? 1.0 : 0.0;
+			}
+
+			uint64_t word = 0;
+			for (int j = 0; j < m; j++)
+				word |= (uint64_t)(bits[j] != 0.0) << j;
+			row[w] = word;
+		}
+	}
+}
+
+/*************************************************************************
+  Проверка каталога на тень: count орбит (начальные состояния в момент 0
+  отдельными массивами координат), nq моментов времени t, sunvec - как в
+  illumination (направление лучей). Флаги упакованы по битам: орбита i
+  занимает SCREENWORDS(nq) слов, момент j - бит j%64 слова j/64.
+  Орбиты делятся между threads потоками целыми строками, так что потоки
+  не пишут в одни слова. Возвращает число пропущенных (незамкнутых)
+  орбит - их флаги нулевые.
+ *************************************************************************/
+int screening(int count, const double * x, const double * y, const double * z,
+	const double * vx, const double * vy, const double * vz,
+	int nq, const double * t, const double sunvec[3], uint64_t * flags, int threads)
+{
+	ScreenElements el;
+	screenelements(count, x, y, z, vx, vy, vz, el);
+
+	double sn = sqrt(sunvec[0]*sunvec[0] + sunvec[1]*sunvec[1] + sunvec[2]*sunvec[2]);
+	double S[3];
+	for (int k = 0; k < 3; k++)
+		S[k] = -AU*sunvec[k]/sn;
+
+	if (threads < 1)
+		threads = 1;
+	if (threads > count)
+		threads = (count > 0) ? count : 1;
+
+	std::vector<std::thread> workers;
+	for (int p = 0; p < threads; p++)
+	{
+		int first = (int)((long long)count*p/threads);
+		int last = (int)((long long)count*(p + 1)/threads);
+		workers.push_back(std::thread(screenrange, std::cref(el), first, last, nq, t, S, flags));
+	}
+	for (size_t p = 0; p < workers.size(); p++)
+		workers[p].join();
+
+	int skipped = 0;
+	for (int i = 0; i < count; i++)
+		skipped += !el.valid[i];
+	return skipped;
+}
+
+int screenflag(const uint64_t * flags, int nq, int i, int j)
+{
+	return (int)((flags[(size_t)i*SCREENWORDS(nq) + j/64] >> (j%64)) & 1);
+}
+
+/*************************************************************************
+  Пропускная способность на случайном каталоге: орбиты от низких до
+  геостационарных (радиус перицентра 1.05..6.6, e до 0.3, наклон любой),
+  моменты равномерно на 100 единицах времени (~16 витков низкой орбиты).
+ *************************************************************************/
+void screeningbenchmark(int count, int nq, int threads)
+{
+	std::vector<double> x(count), y(count), z(count), vx(count), vy(count), vz(count);
+	std::vector<double> t(nq);
+
+	srand(1);
+	for (int i = 0; i < count; i++)
+	{
+		double rp = 1.05 + 5.55*rand()/(double)RAND_MAX;
+		double e = 0.3*rand()/(double)RAND_MAX;
+		double inc = SCREENPI*rand()/(double)RAND_MAX;
+		double node = 2.0*SCREENPI*rand()/(double)RAND_MAX;
+
+		// Начальная точка - перицентр, скорость по vis-viva
+		double vp = sqrt(M*(1.0 + e)/rp);
+		double ux = cos(node), uy = sin(node);
+		double wx = -sin(node)*cos(inc), wy = cos(node)*cos(inc), wz = sin(inc);
+		x[i] = rp*ux; y[i] = rp*uy; z[i] = 0;
+		vx[i] = vp*wx; vy[i] = vp*wy; vz[i] = vp*wz;
+	}
+	for (int j = 0; j < nq; j++)
+		t[j] = 100.0*j/nq;
+
+	double sunvec[3] = {0, -1, 0};
+	std::vector<uint64_t> flags((size_t)count*SCREENWORDS(nq));
+
+	auto t0 = std::chrono::steady_clock::now();
+	screening(count, &x[0], &y[0], &z[0], &vx[0], &vy[0], &vz[0], nq, &t[0], sunvec, &flags[0], 1);
+	auto t1 = std::chrono::steady_clock::now();
+	screening(count, &x[0], &y[0], &z[0], &vx[0], &vy[0], &vz[0], nq, &t[0], sunvec, &flags[0], threads);
+	auto t2 = std::chrono::steady_clock::now();
+
+	long long shadow = 0;
+	for (size_t k = 0; k < flags.size(); k++)
+		shadow += __builtin_popcountll(flags[k]);
+
+	double q = (double)count*nq;
+	double s1 = std::chrono::duration<double>(t1 - t0).count();
+	double sn = std::chrono::duration<double>(t2 - t1).count();
+	std::cout<<"QUERIES "<<q<<" IN SHADOW "<<shadow/q<<std::endl;
+	std::cout<<"1 THREAD "<<q/s1<<" QUERIES/S"<<std::endl;
+	std::cout<<threads<<" THREADS "<<q/sn<<" QUERIES/S"<<std::endl;
+}
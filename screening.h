@@ -0,0 +1,15 @@
+#ifndef SCREENING_H
+#define SCREENING_H
+
+#include <stdint.h>
+
+// Число 64-битных слов флагов на одну орбиту
+#define SCREENWORDS(nq) (((nq) + 63)/64)
+
+int screening(int count, const double * x, const double * y, const double * z,
+	const double * vx, const double * vy, const double * vz,
+	int nq, const double * t, const double sunvec[3], uint64_t * flags, int threads);
+int screenflag(const uint64_t * flags, int nq, int i, int j);
+void screeningbenchmark(int count, int nq, int threads);
+
+#endif // SCREENING_H